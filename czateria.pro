@@ -1,4 +1,5 @@
 TEMPLATE = subdirs
-SUBDIRS = czatlib ui
+SUBDIRS = czatlib ui replay mockserver
 
 ui.depends = czatlib
+replay.depends = czatlib
@@ -8,6 +8,8 @@
 #include <QNetworkRequest>
 #include <QRegularExpression>
 
+#include "endpoints.h"
+
 namespace Czateria {
 Captcha::Captcha(QNetworkAccessManager *nam, QObject *parent)
     : QObject(parent), mNAM(nam) {}
@@ -16,8 +18,8 @@ void Captcha::get() {
   auto callbackName = QString(QLatin1String("jQuery16202627191567764926_%1"))
                           .arg(QDateTime::currentMSecsSinceEpoch());
   auto requestAddr =
-      QString(QLatin1String("https://czateria-api.interia.pl/captcha/"
-                            "getEnigmaJS?type=1&ctime=300&callback=%1"))
+      Endpoints::captcha() +
+      QString(QLatin1String("getEnigmaJS?type=1&ctime=300&callback=%1"))
           .arg(callbackName);
   qDebug() << requestAddr;
   auto captchaRequest = mNAM->get(QNetworkRequest(QUrl(requestAddr)));
@@ -5,11 +5,19 @@
 #include <QString>
 
 namespace Czateria {
+/* the checks are done by the sessions' connections, which may be running on
+ * worker threads. they must therefore be safe to call from any thread, even
+ * while the blocker is being changed. */
 class ChatBlocker : public QObject {
   Q_OBJECT
 public:
   virtual bool isUserBlocked(const QString &nickname) const = 0;
   virtual bool isMessageBlocked(const QString &content) const = 0;
+  // lets the messages' text go undecoded when nothing would match it anyway.
+  virtual bool hasMessageFilters() const { return true; }
+  // blocks the user for as long as the blocker is around, without touching
+  // any of the lists the user sees. does nothing unless overridden.
+  virtual void blockTemporarily(const QString &) {}
 
 signals:
   void changed();
@@ -0,0 +1,360 @@
+#include "chatconnection.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QDebug>
+#include <QImageReader>
+#include <QLoggingCategory>
+#include <QThread>
+#include <QWebSocket>
+
+#include "chatblocker.h"
+#include "framewriter.h"
+#include "sessionrecording.h"
+#include "tlssessioncache.h"
+
+namespace {
+// formatting every frame is only worth it if someone's going to read it, so
+// this category is disabled by default. the frames are always available in the
+// session's WireTrace, though.
+Q_LOGGING_CATEGORY(lcWire, "czateria.wire", QtInfoMsg)
+
+#define trace_frame(direction, raw_msg)                                        \
+  do {                                                                         \
+    mWireTrace.record(WireTrace::Direction::direction, raw_msg);               \
+    qCDebug(lcWire).noquote().nospace()                                        \
+        << QString(QLatin1String("[%1] ")).arg(mLabel)                         \
+        << (WireTrace::Direction::direction == WireTrace::Direction::Inbound   \
+                ? QLatin1String("< ")                                          \
+                : QLatin1String("> "))                                         \
+        << raw_msg;                                                            \
+  } while (0)
+
+void registerMetaTypes() {
+  static const bool registered = []() {
+    qRegisterMetaType<Czateria::InboundBatch>();
+    qRegisterMetaType<Czateria::OutboundQueue::Priority>();
+    qRegisterMetaType<Czateria::OutboundQueue::Limits>();
+    qRegisterMetaType<QAbstractSocket::SocketError>();
+    return true;
+  }();
+  Q_UNUSED(registered);
+}
+
+Czateria::ChatConnection::HealthCheck &defaultHealthCheckStorage() {
+  static Czateria::ChatConnection::HealthCheck healthCheck;
+  return healthCheck;
+}
+
+QByteArray sniffImageFormat(const QByteArray &data) {
+  // the formats people actually send, which saves going through all the
+  // image plugins just to find out what it is.
+  if (data.startsWith("\xff\xd8\xff")) {
+    return QByteArrayLiteral("jpeg");
+  } else if (data.startsWith("\x89PNG\r\n\x1a\n")) {
+    return QByteArrayLiteral("png");
+  } else if (data.startsWith("GIF87a") || data.startsWith("GIF89a")) {
+    return QByteArrayLiteral("gif");
+  }
+  QBuffer buf;
+  buf.setData(data);
+  buf.open(QIODevice::ReadOnly);
+  return QImageReader::imageFormat(&buf);
+}
+
+void decodeImage(Czateria::InboundFrame &frame) {
+  if (frame.privateEvent.data.isNull()) {
+    return;
+  }
+  frame.image = frame.privateEvent.data;
+  frame.imageFormat = sniffImageFormat(frame.image);
+}
+} // namespace
+
+namespace Czateria {
+
+ChatConnection::ChatConnection(const QUrl &host, const QString &roomName,
+                               const QString &nickname,
+                               const ChatBlocker &blocker, QThread *thread)
+    : mHost(host), mRoomName(roomName), mNickname(nickname),
+      mBlocker(blocker), mLabel(QString(QLatin1String("%1@%2"))
+                                    .arg(mNickname, mRoomName)),
+      mPending(std::make_shared<std::vector<InboundFrame>>()),
+      mHealthCheck(defaultHealthCheck()) {
+  registerMetaTypes();
+  mWireTrace.setLabel(mLabel);
+  mMetrics.setLabel(mLabel);
+  if (thread) {
+    moveToThread(thread);
+  }
+  connect(this, &ChatConnection::setupRequested, this, &ChatConnection::setup);
+  connect(this, &ChatConnection::openRequested, this, [=]() {
+    // whatever was in flight on the old connection is gone, but whatever
+    // still waits in the queue goes out once the session logs back in.
+    mOutbound->setHeld(true);
+    mOutbound->resetInFlight();
+    mPingTimer->stop();
+    mIncoming.clear();
+    TlsSessionCache::instance().prepare(mWebSocket, mHost);
+    mWebSocket->open(mHost);
+  });
+  // the session waits for this one, as it's about to go away along with the
+  // blocker, and nothing that arrives afterwards may be decoded.
+  connect(this, &ChatConnection::closeRequested, this,
+          [=]() {
+            mWebSocket->disconnect(this);
+            mPingTimer->stop();
+            mOutbound->send(FrameWriter::sessionEnd(),
+                            OutboundQueue::Priority::Control);
+            mWebSocket->close();
+          },
+          thread && thread != QThread::currentThread()
+              ? Qt::BlockingQueuedConnection
+              : Qt::DirectConnection);
+  connect(this, &ChatConnection::sendRequested, this,
+          [=](const QString &frame, OutboundQueue::Priority priority) {
+            if (!mOutbound->send(frame, priority)) {
+              qInfo() << "Too much data waiting to be sent, dropping"
+                      << (priority == OutboundQueue::Priority::Image
+                              ? "image"
+                              : "message")
+                      << "on" << mLabel;
+              emit frameDropped(priority);
+            }
+          });
+  connect(this, &ChatConnection::heldRequested, this,
+          [=](bool held) { mOutbound->setHeld(held); });
+  connect(this, &ChatConnection::limitsRequested, this,
+          [=](const OutboundQueue::Limits &limits) {
+            mOutbound->setLimits(limits);
+          });
+  connect(this, &ChatConnection::labelRequested, this,
+          [=](const QString &label) {
+            mLabel = label;
+            mWireTrace.setLabel(label);
+            mMetrics.setLabel(label);
+          });
+  connect(this, &ChatConnection::pausedRequested, this, [=](bool paused) {
+    mPaused = paused;
+    if (!mPaused) {
+      flush();
+    }
+  });
+  // always queued, so that everything which arrives in one go ends up in the
+  // same batch.
+  connect(this, &ChatConnection::flushRequested, this, &ChatConnection::flush,
+          Qt::QueuedConnection);
+  emit setupRequested(QPrivateSignal());
+}
+
+ChatConnection::~ChatConnection() = default;
+
+void ChatConnection::setDefaultHealthCheck(const HealthCheck &healthCheck) {
+  defaultHealthCheckStorage() = healthCheck;
+}
+
+const ChatConnection::HealthCheck &ChatConnection::defaultHealthCheck() {
+  return defaultHealthCheckStorage();
+}
+
+void ChatConnection::open() { emit openRequested(QPrivateSignal()); }
+
+void ChatConnection::close() { emit closeRequested(QPrivateSignal()); }
+
+void ChatConnection::send(const QString &frame,
+                          OutboundQueue::Priority priority) {
+  emit sendRequested(frame, priority, QPrivateSignal());
+}
+
+void ChatConnection::setHeld(bool held) {
+  emit heldRequested(held, QPrivateSignal());
+}
+
+void ChatConnection::setLimits(const OutboundQueue::Limits &limits) {
+  emit limitsRequested(limits, QPrivateSignal());
+}
+
+void ChatConnection::setLabel(const QString &label) {
+  emit labelRequested(label, QPrivateSignal());
+}
+
+void ChatConnection::setPaused(bool paused) {
+  emit pausedRequested(paused, QPrivateSignal());
+}
+
+void ChatConnection::setup() {
+  // the socket needs to be created on the thread it's going to be used on, as
+  // not all of its innards would follow it through a moveToThread().
+  mWebSocket =
+      new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+  mOutbound = new OutboundQueue(mWebSocket, this);
+  // nothing but the login is sent until the server says hello.
+  mOutbound->setHeld(true);
+  mPingTimer = new QTimer(this);
+  mPingTimer->setInterval(mHealthCheck.pingInterval);
+  connect(mPingTimer, &QTimer::timeout, this, &ChatConnection::checkHealth);
+  connect(mWebSocket, &QWebSocket::textFrameReceived, this,
+          [=](const QString &text, bool isLastFrame) {
+            // QWebSocket only hands out text frames already converted to
+            // UTF-16, so there's no way around converting them back here. the
+            // rest of the way, up until the point where a message is
+            // displayed, is UTF-8 only.
+            // large messages, like images, come in fragments, which are
+            // converted as they arrive rather than all at once at the end.
+            if (isLastFrame && mIncoming.isEmpty()) {
+              const auto frame = text.toUtf8();
+              trace_frame(Inbound, frame);
+              onFrameReceived(frame);
+              return;
+            }
+            mIncoming.append(text.toUtf8());
+            if (isLastFrame) {
+              trace_frame(Inbound, mIncoming);
+              onFrameReceived(mIncoming);
+              mIncoming.clear();
+            }
+          });
+  connect(mWebSocket, &QWebSocket::binaryMessageReceived, this,
+          [=](const QByteArray &frame) {
+            trace_frame(Inbound, frame);
+            onFrameReceived(frame);
+          });
+  void (QWebSocket::*errSig)(QAbstractSocket::SocketError) = &QWebSocket::error;
+  connect(mWebSocket, errSig, this, &ChatConnection::onSocketError);
+  connect(mWebSocket, &QWebSocket::connected, this, [=]() {
+    if (mHealthCheck.pingInterval > 0) {
+      mAnswersPings = false;
+      mStalled = false;
+      mLastHeard.start();
+      mPingTimer->start();
+    }
+  });
+  // a connection going away unasked for is about to be reconnected, and for
+  // rooms which weren't warmed up in advance, there's no ticket to resume the
+  // session with yet. getting one takes a handshake of its own, which is why
+  // it's only done once a reconnect is actually coming, while the session
+  // waits before making it. closing on purpose disconnects this beforehand.
+  connect(mWebSocket, &QWebSocket::disconnected, this, [=]() {
+    mPingTimer->stop();
+    auto &tlsSessions = TlsSessionCache::instance();
+    if (!tlsSessions.hasTicket(mHost)) {
+      tlsSessions.warmUp(mHost);
+    }
+  });
+  connect(mWebSocket, &QWebSocket::pong, this, [=](quint64 elapsedTime) {
+    mAnswersPings = true;
+    noteHeard();
+    mMetrics.pongRtt.add(static_cast<qint64>(elapsedTime));
+  });
+  connect(mOutbound, &OutboundQueue::aboutToSend, this,
+          [=](const QString &frame) {
+            trace_frame(Outbound, frame);
+            emit frameSent();
+          });
+  const auto &recordDirectory = SessionRecorder::recordDirectory();
+  if (!recordDirectory.isEmpty()) {
+    mRecorder = std::make_unique<SessionRecorder>(
+        SessionRecorder::pathForRoom(recordDirectory, mRoomName), mRoomName,
+        mNickname);
+  }
+}
+
+void ChatConnection::onFrameReceived(const QByteArray &frame) {
+  noteHeard();
+  if (mRecorder) {
+    mRecorder->record(frame);
+  }
+  InboundFrame decoded;
+  if (!decode(frame, mBlocker, mNickname, decoded)) {
+    return;
+  }
+  if (mPending->empty()) {
+    emit flushRequested(QPrivateSignal());
+  }
+  mPending->push_back(std::move(decoded));
+}
+
+void ChatConnection::onSocketError(QAbstractSocket::SocketError error) {
+  // anything received before the error is handled first.
+  flush();
+  emit socketError(error, mWebSocket->errorString());
+}
+
+void ChatConnection::checkHealth() {
+  // servers which never answered a ping can't be told apart from dead ones
+  // this way, so those are left to the keepalives and the OS.
+  if (mAnswersPings && mLastHeard.elapsed() >= mHealthCheck.deadAfter) {
+    qInfo() << "Nothing heard from the server for" << mLastHeard.elapsed()
+            << "ms, giving up on the connection" << mLabel;
+    mPingTimer->stop();
+    mWebSocket->abort();
+    flush();
+    emit socketError(QAbstractSocket::SocketTimeoutError,
+                     tr("The server stopped responding"));
+    return;
+  }
+  // one ping went unanswered.
+  if (mAnswersPings && !mStalled &&
+      mLastHeard.elapsed() > mHealthCheck.pingInterval * 3 / 2) {
+    mStalled = true;
+    emit stalledChanged(true);
+  }
+  mWebSocket->ping();
+}
+
+void ChatConnection::noteHeard() {
+  mLastHeard.start();
+  if (mStalled) {
+    mStalled = false;
+    emit stalledChanged(false);
+  }
+}
+
+void ChatConnection::flush() {
+  if (mPaused || mPending->empty()) {
+    return;
+  }
+  emit framesReceived(mPending);
+  mPending = std::make_shared<std::vector<InboundFrame>>();
+}
+
+bool ChatConnection::decode(const QByteArray &frame, const ChatBlocker &blocker,
+                            const QString &ownNickname, InboundFrame &out) {
+  if (!FrameDecoder::decode(frame, out)) {
+    qInfo() << "Could not parse message";
+    qInfo().noquote() << QString::fromUtf8(frame);
+    return false;
+  }
+  if (!out.decoded) {
+    return true;
+  }
+  // the message's text is only decoded to check it when there's something to
+  // check it against, and its author isn't blocked or us anyway.
+  const auto checkMessage = [&] {
+    out.messageBlocked = !out.userBlocked && blocker.hasMessageFilters() &&
+                         blocker.isMessageBlocked(out.message.rawMessage());
+  };
+  switch (out.header.code) {
+  case 129:
+    if (out.message.nickname() != ownNickname) {
+      out.userBlocked = blocker.isUserBlocked(out.message.nickname());
+      checkMessage();
+    }
+    break;
+  case 97: {
+    const auto &event = out.privateEvent;
+    out.userBlocked = blocker.isUserBlocked(event.user);
+    if (event.subcode == 1 || event.subcode == 2) {
+      out.message = Message::fromUtf8(QDateTime::currentDateTime(), event.msg,
+                                      event.user);
+      checkMessage();
+    } else if (event.subcode == 25) {
+      decodeImage(out);
+    }
+    break;
+  }
+  }
+  return true;
+}
+
+} // namespace Czateria
@@ -0,0 +1,142 @@
+#ifndef CHATCONNECTION_H
+#define CHATCONNECTION_H
+
+#include <QAbstractSocket>
+#include <QByteArray>
+#include <QMetaType>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+#include <vector>
+
+#include "framedecoder.h"
+#include "outboundqueue.h"
+#include "sessionmetrics.h"
+#include "wiretrace.h"
+
+class QThread;
+class QWebSocket;
+
+namespace Czateria {
+
+class ChatBlocker;
+class SessionRecorder;
+
+using InboundBatch = std::shared_ptr<std::vector<InboundFrame>>;
+
+/* the part of a ChatSession which actually talks to the server : the socket,
+ * the outbound queue, and turning the frames received into InboundFrames,
+ * blocker checks included. all of this may happen on one of the
+ * SessionThreads, which is why the functions below only ever pass the call on
+ * to the connection's own thread, and why everything coming back is done
+ * through signals.
+ * decoded frames are handed over in batches, containing whatever arrived
+ * before the connection's thread got around to sending them. */
+class ChatConnection : public QObject {
+  Q_OBJECT
+public:
+  /* the socket is pinged every pingInterval. once the server has shown that
+   * it answers pings, hearing nothing at all from it for deadAfter means that
+   * the connection is gone, which is reported as a SocketTimeoutError. a ping
+   * interval of 0 disables all of this. */
+  struct HealthCheck {
+    int pingInterval = 20000;
+    int deadAfter = 60000;
+  };
+  // used for all connections created afterwards.
+  static void setDefaultHealthCheck(const HealthCheck &healthCheck);
+  static const HealthCheck &defaultHealthCheck();
+
+  // a null thread means the current one.
+  ChatConnection(const QUrl &host, const QString &roomName,
+                 const QString &nickname, const ChatBlocker &blocker,
+                 QThread *thread = nullptr);
+  ~ChatConnection() override;
+
+  void open();
+  // sends the session end frame before closing the socket. waits for that
+  // to happen if the connection is on a different thread.
+  void close();
+  void send(const QString &frame, OutboundQueue::Priority priority);
+  void setHeld(bool held);
+  void setLimits(const OutboundQueue::Limits &limits);
+  void setLabel(const QString &label);
+  // while paused, decoded frames are held rather than handed over.
+  void setPaused(bool paused);
+
+  // safe to use from any thread.
+  const WireTrace &wireTrace() const { return mWireTrace; }
+  SessionMetrics &metrics() { return mMetrics; }
+  const SessionMetrics &metrics() const { return mMetrics; }
+
+  // does everything done to the frames received, save for actually handling
+  // them. returns false if the frame isn't even valid JSON.
+  static bool decode(const QByteArray &frame, const ChatBlocker &blocker,
+                     const QString &ownNickname, InboundFrame &out);
+
+signals:
+  void framesReceived(const Czateria::InboundBatch &frames);
+  void frameSent();
+  // the frame had to be dropped, as too much was already waiting to be sent.
+  void frameDropped(Czateria::OutboundQueue::Priority priority);
+  void socketError(QAbstractSocket::SocketError error,
+                   const QString &errorString);
+  // a server which answers pings went quiet for a while, without being given
+  // up on yet. whatever's sent meanwhile may well never arrive.
+  void stalledChanged(bool stalled);
+
+  // used for getting over to the connection's thread.
+  void setupRequested(QPrivateSignal);
+  void openRequested(QPrivateSignal);
+  void closeRequested(QPrivateSignal);
+  void sendRequested(const QString &frame,
+                     Czateria::OutboundQueue::Priority priority,
+                     QPrivateSignal);
+  void heldRequested(bool held, QPrivateSignal);
+  void limitsRequested(const Czateria::OutboundQueue::Limits &limits,
+                       QPrivateSignal);
+  void labelRequested(const QString &label, QPrivateSignal);
+  void pausedRequested(bool paused, QPrivateSignal);
+  void flushRequested(QPrivateSignal);
+
+private:
+  void setup();
+  void onFrameReceived(const QByteArray &frame);
+  void onSocketError(QAbstractSocket::SocketError error);
+  void checkHealth();
+  void noteHeard();
+  void flush();
+
+  const QUrl mHost;
+  const QString mRoomName;
+  const QString mNickname;
+  const ChatBlocker &mBlocker;
+  QString mLabel;
+  QWebSocket *mWebSocket = nullptr;
+  OutboundQueue *mOutbound = nullptr;
+  // the fragments of the message being received so far, in UTF-8.
+  QByteArray mIncoming;
+  std::unique_ptr<SessionRecorder> mRecorder;
+  WireTrace mWireTrace;
+  SessionMetrics mMetrics;
+  InboundBatch mPending;
+  bool mPaused = false;
+
+  const HealthCheck mHealthCheck;
+  QTimer *mPingTimer = nullptr;
+  QElapsedTimer mLastHeard;
+  bool mAnswersPings = false;
+  bool mStalled = false;
+};
+
+} // namespace Czateria
+
+Q_DECLARE_METATYPE(Czateria::InboundBatch)
+Q_DECLARE_METATYPE(Czateria::OutboundQueue::Priority)
+Q_DECLARE_METATYPE(Czateria::OutboundQueue::Limits)
+
+#endif // CHATCONNECTION_H
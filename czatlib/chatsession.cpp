@@ -1,147 +1,64 @@
 #include "chatsession.h"
 
-#include <QBuffer>
-#include <QImageReader>
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QRegularExpression>
-#include <QRegularExpressionMatch>
-#include <QTimerEvent>
-#include <QWebSocket>
+#include <QDebug>
+#include <QImage>
+#include <QPointer>
 
+#include <algorithm>
 #include <array>
+#include <iterator>
+#include <random>
 
 #include "chatblocker.h"
+#include "chatconnection.h"
 #include "chatsessionlistener.h"
+#include "endpoints.h"
+#include "framedecoder.h"
+#include "framewriter.h"
 #include "icons.h"
+#include "imageencoder.h"
+#include "keepalivescheduler.h"
 #include "loginsession.h"
 #include "message.h"
+#include "pendingconnections.h"
+#include "pendingmessages.h"
+#include "sessionmetrics.h"
+#include "sessionthreads.h"
 #include "userlistmodel.h"
 #include "util.h"
 
 namespace {
-constexpr auto keepaliveInterval = 40000;
-
-QJsonObject czateriaCodeMsg(int code) {
-  QJsonObject obj;
-  obj.insert(QLatin1String("code"), code);
-  return obj;
-}
-
-QJsonObject czateriaSubcodeMsg(int code, int subcode) {
-  auto obj = czateriaCodeMsg(code);
-  obj.insert(QLatin1String("subcode"), subcode);
-  return obj;
-}
-
-QJsonObject loginMsg(const QString &sessionId, const QString &channelName,
-                     const QString &nickname) {
-  auto obj = czateriaCodeMsg(108);
-  obj.insert(QLatin1String("login"), nickname);
-  obj.insert(QLatin1String("cryptLogin"), QLatin1String(""));
-  obj.insert(QLatin1String("slowLogin"), false);
-  obj.insert(QLatin1String("sessionId"), sessionId);
-  obj.insert(QLatin1String("channelName"), channelName);
-  obj.insert(QLatin1String("localIp"), QLatin1String("127.0.0.1"));
-  obj.insert(QLatin1String("nickColorId"), 0);
-  obj.insert(QLatin1String("emotionId"), 0);
-  obj.insert(QLatin1String("cardDate"), QLatin1String("0"));
-  obj.insert(QLatin1String("cardReasonId"), 0);
-  obj.insert(QLatin1String("cardSex"), QLatin1String("0"));
-  obj.insert(QLatin1String("cardDescription"), QLatin1String(""));
-  obj.insert(QLatin1String("cardSearchSex"), QLatin1String("0"));
-  obj.insert(QLatin1String("cardSearchAgeFrom"), 0);
-  obj.insert(QLatin1String("cardSearchAgeTo"), 0);
-  obj.insert(QLatin1String("isHiddenMode"), 0);
-  obj.insert(QLatin1String("lat"), 0);
-  obj.insert(QLatin1String("lon"), 0);
-  return obj;
-}
-
-void messageCommon(QJsonObject &obj, const QString &message) {
-  obj.insert(QLatin1String("msg"), Czateria::textIconsToTags(message));
-  obj.insert(QLatin1String("msgColorId"), 0);
-  obj.insert(QLatin1String("msgFontTypeId"), 0);
-  obj.insert(QLatin1String("msgIsBold"), false);
-  obj.insert(QLatin1String("msgIsItalic"), false);
-  obj.insert(QLatin1String("msgIsUnderline"), false);
-}
-
-QJsonObject messageMsg(const QString &message) {
-  auto obj = czateriaCodeMsg(1);
-  messageCommon(obj, message);
-  return obj;
-}
-
-QJsonObject privRejectMsg(const QString &nickname) {
-  QJsonObject obj = czateriaSubcodeMsg(97, 13);
-  obj.insert(QLatin1String("user"), nickname);
-  return obj;
-}
-
-QJsonObject privMessageMsg(const QString &message, const QString &nickname) {
-  auto obj = czateriaSubcodeMsg(97, 2);
-  messageCommon(obj, message);
-  obj.insert(QLatin1String("user"), nickname);
-  return obj;
-}
-
-QJsonObject privInviteMsg(const QString &message, const QString &nickname) {
-  auto obj = czateriaSubcodeMsg(97, 1);
-  messageCommon(obj, message);
-  obj.insert(QLatin1String("user"), nickname);
-  return obj;
-}
-
-QJsonObject privClosedMsg(const QString &nickname) {
-  QJsonObject obj = czateriaSubcodeMsg(97, 14);
-  obj.insert(QLatin1String("user"), nickname);
-  return obj;
-}
-
-QJsonObject privImageMsg(const QString &nickname, const QImage &image) {
-  QJsonObject obj = czateriaSubcodeMsg(97, 25);
-  obj.insert(QLatin1String("user"), nickname);
-  obj.insert(QLatin1String("type"), 1);
-  obj.insert(QLatin1String("imgWidth"), image.width());
-  obj.insert(QLatin1String("imgHeight"), image.height());
-  QByteArray imageData;
-  QBuffer buf(&imageData);
-  buf.open(QIODevice::WriteOnly);
-  image.save(&buf, "JPG", -1);
-  obj.insert(QLatin1String("data"), QString::fromLatin1(imageData.toBase64()));
-  return obj;
-}
-
-QJsonObject sessionEndMsg() { return czateriaCodeMsg(80); }
-
-QJsonObject keepaliveMsg() { return czateriaCodeMsg(1003); }
-
-bool shouldUseQueuedConnectionForWebSocket() {
-  // QTBUG-55506
-  static QVariant cached_result;
-  if (cached_result.isValid()) {
-    return cached_result.toBool();
-  }
-  auto re = QRegularExpression(QLatin1String("(\\d+)\\.(\\d+)"));
-  auto m = re.match(QString::fromLatin1(qVersion()));
-  std::array<int, 2> qt_ver;
-  using array_size_t = decltype(qt_ver)::size_type;
-  bool all_ok = true;
-  for (int i = 0; i < static_cast<int>(qt_ver.size()); ++i) {
-    bool ok;
-    qt_ver[static_cast<array_size_t>(i)] = m.captured(i + 1).toInt(&ok);
-    all_ok &= ok;
-  }
-  bool rv;
-  if (all_ok && qt_ver[0] >= 5 && qt_ver[1] >= 8) {
-    rv = false;
-  } else {
-    rv = true;
+constexpr int minReconnectDelay = 1000;
+constexpr int maxReconnectDelay = 60000;
+constexpr int maxReconnectAttempts = 10;
+constexpr int floodReportInterval = 10000;
+// echoes which don't come back within this long aren't coming back at all.
+constexpr qint64 maxEchoWait = 60000;
+constexpr std::size_t maxPendingEchoes = 16;
+
+int reconnectDelay(int attempt) {
+  // exponential backoff, with the actual delay picked at random from the upper
+  // half of the range. this way, sessions which got disconnected at the same
+  // time don't all come back at the same time as well.
+  static std::mt19937 random{std::random_device{}()};
+  const auto ceiling =
+      std::min(maxReconnectDelay, minReconnectDelay << std::min(attempt, 16));
+  std::uniform_int_distribution<int> dist(ceiling / 2, ceiling);
+  return dist(random);
+}
+
+bool isErrorTransient(QAbstractSocket::SocketError err) {
+  switch (err) {
+  case QAbstractSocket::RemoteHostClosedError:
+  case QAbstractSocket::HostNotFoundError:
+  case QAbstractSocket::ConnectionRefusedError:
+  case QAbstractSocket::SocketTimeoutError:
+  case QAbstractSocket::NetworkError:
+  case QAbstractSocket::TemporaryError:
+    return true;
+  default:
+    return false;
   }
-  cached_result = rv;
-  return rv;
 }
 
 bool privSubcodeToState(int subcode, Czateria::ConversationState &state) {
@@ -155,29 +72,16 @@ bool privSubcodeToState(int subcode, Czateria::ConversationState &state) {
   return CzateriaUtil::convert(subcode, state, subcodeToState);
 }
 
-void reportUnhandled(const QString &message) {
-  qInfo().noquote() << "Unhandled WebSocket message :\n" << message;
-}
-
-#define emit_debug_line(obj, raw_msg, direction)                               \
-  do {                                                                         \
-    auto user_ = obj[QLatin1String("user")];                                   \
-    qDebug().noquote().nospace()                                               \
-        << QString(QLatin1String("[%1|%2] ")).arg(mNickname).arg(mRoom.name)   \
-        << (user_.isString() ? (QString(QLatin1String("[user: %1] "))          \
-                                    .arg(user_.toString()))                    \
-                             : QString())                                      \
-        << QLatin1String(direction " ") << raw_msg;                            \
-  } while (0)
-
-#define SendTextMessage(webSocket, json_obj)                                   \
-  do {                                                                         \
-    auto json_obj_ = json_obj;                                                 \
-    auto message_ = QString::fromUtf8(                                         \
-        QJsonDocument(json_obj_).toJson(QJsonDocument::Compact));              \
-    emit_debug_line(json_obj_, message_, ">");                                 \
-    webSocket->sendTextMessage(message_);                                      \
-  } while (0)
+void reportUnhandled(const QByteArray &message) {
+  qInfo().noquote() << "Unhandled WebSocket message :\n"
+                    << QString::fromUtf8(message);
+}
+
+Czateria::ChatSession::DispatchPolicy &defaultDispatchPolicyStorage() {
+  static Czateria::ChatSession::DispatchPolicy policy;
+  return policy;
+}
+
 } // namespace
 
 namespace Czateria {
@@ -186,42 +90,154 @@ ChatSession::ChatSession(QSharedPointer<LoginSession> login,
                          const AvatarHandler &avatars, const Room &room,
                          const ChatBlocker &blocker,
                          ChatSessionListener *listener, QObject *parent)
-    : QObject(parent), mWebSocket(new QWebSocket(
-                           QString(), QWebSocketProtocol::VersionLatest, this)),
-      mNickname(login->nickname()),
-      mHost(QString(QLatin1String("wss://%1-proxy-czateria.interia.pl"))
-                .arg(room.port)),
-      mHelloReceived(false),
+    : QObject(parent), mNickname(login->nickname()),
+      mHost(Endpoints::chatServer(room.port)),
       mUserListModel(new UserListModel(avatars, blocker, this)),
       mLoginSession(login), mRoom(room), mBlocker(blocker),
-      mListener(listener) {
-  connect(this, &ChatSession::userLeft, mUserListModel,
-          &UserListModel::removeUser);
-  connect(mWebSocket, &QWebSocket::textMessageReceived, this,
-          &ChatSession::onTextMessageReceived,
-          shouldUseQueuedConnectionForWebSocket() ? Qt::QueuedConnection
-                                                  : Qt::AutoConnection);
-  void (QWebSocket::*errSig)(QAbstractSocket::SocketError) = &QWebSocket::error;
-  connect(mWebSocket, errSig, this, &ChatSession::onSocketError);
+      mListener(listener), mDispatchPolicy(defaultDispatchPolicy()),
+      mOutbox(QString(QLatin1String("%1@%2")).arg(mNickname, room.name)) {
+  // the connection may have been opened already while logging in.
+  if (PendingConnections::instance().take(mRoom, mNickname, mConnection,
+                                          mThread)) {
+    mSocketState = SocketState::Opening;
+  } else {
+    mThread = SessionThreads::instance().acquire();
+    mConnection =
+        new ChatConnection(mHost, mRoom.name, mNickname, mBlocker, mThread);
+  }
+  connect(mConnection, &ChatConnection::framesReceived, this,
+          [=](const InboundBatch &frames) { handleFrames(*frames); });
+  connect(mConnection, &ChatConnection::socketError, this,
+          &ChatSession::onSocketError);
+  connect(mConnection, &ChatConnection::frameSent, this, [=]() {
+    KeepaliveScheduler::instance().noteTraffic(mKeepaliveId);
+  });
+  connect(mConnection, &ChatConnection::stalledChanged, this,
+          [=](bool stalled) {
+            mConnectionStalled = stalled;
+            if (!stalled && mState == ConnectionState::Connected) {
+              flushOutbox();
+            }
+          });
+  connect(mConnection, &ChatConnection::frameDropped, this,
+          [=](OutboundQueue::Priority priority) {
+            emit sendDropped(priority == OutboundQueue::Priority::Image);
+          });
   connect(mLoginSession.data(), &LoginSession::loginSuccessful, this,
           &ChatSession::start);
+  connect(mLoginSession.data(), &LoginSession::loginFailed, this,
+          [=](LoginFailReason why) {
+            if (mState != ConnectionState::Reconnecting) {
+              return;
+            }
+            if (why == LoginFailReason::Unknown) {
+              // most likely the network not being back yet.
+              scheduleReconnect();
+            } else {
+              mState = ConnectionState::Idle;
+              emit sessionExpired();
+            }
+          });
+  mEchoClock.start();
+  mFloodReportTimer.setInterval(floodReportInterval);
+  connect(&mFloodReportTimer, &QTimer::timeout, this,
+          &ChatSession::reportSuppressedMessages);
+  mReconnectTimer.setSingleShot(true);
+  connect(&mReconnectTimer, &QTimer::timeout, this, [=]() {
+    mState = ConnectionState::Reconnecting;
+    openSocket();
+    mLoginSession->restart(mRoom);
+  });
   connect(&mBlocker, &ChatBlocker::changed, this,
           &ChatSession::onBlockerChanged);
+  connect(this, &ChatSession::sessionError, this, [=]() {
+    const auto &directory = WireTrace::dumpDirectory();
+    if (!directory.isEmpty()) {
+      auto path = mConnection->wireTrace().dumpToDirectory(directory);
+      if (!path.isNull()) {
+        qInfo() << "Session error, wire trace written to" << path;
+      }
+    }
+  });
+  connect(this, &ChatSession::nicknameAssigned, this,
+          &ChatSession::updateWireTraceLabel);
+  updateWireTraceLabel();
+  // whatever a connection opened ahead received so far can be handled now.
+  mConnection->setPaused(false);
 }
 
 ChatSession::~ChatSession() {
-  SendTextMessage(mWebSocket, sessionEndMsg());
-  mWebSocket->close();
+  if (mKeepaliveId) {
+    KeepaliveScheduler::instance().remove(mKeepaliveId);
+  }
+  mConnection->close();
+  // the session may be going away in the middle of handling the connection's
+  // signal, so the connection can't be deleted right away even if it's on
+  // this thread.
+  mConnection->deleteLater();
+  if (mThread) {
+    SessionThreads::instance().release(mThread);
+  }
+}
+
+QString ChatSession::dumpWireTrace(const QString &directory) const {
+  return mConnection->wireTrace().dumpToDirectory(directory);
+}
+
+const SessionMetrics &ChatSession::metrics() const {
+  return mConnection->metrics();
+}
+
+void ChatSession::setOutboundLimits(const OutboundQueue::Limits &limits) {
+  mConnection->setLimits(limits);
+}
+
+void ChatSession::replayFrame(const QByteArray &frame) {
+  // recordings start with the hello, which is replied to as if logged in.
+  if (mState == ConnectionState::Idle) {
+    mState = ConnectionState::Connecting;
+  }
+  InboundFrame decoded;
+  if (ChatConnection::decode(frame, mBlocker, mNickname, decoded)) {
+    handleFrame(decoded);
+  }
+}
+
+void ChatSession::setDefaultDispatchPolicy(const DispatchPolicy &policy) {
+  defaultDispatchPolicyStorage() = policy;
+}
+
+const ChatSession::DispatchPolicy &ChatSession::defaultDispatchPolicy() {
+  return defaultDispatchPolicyStorage();
+}
+
+void ChatSession::updateWireTraceLabel() {
+  const auto label = QString(QLatin1String("%1@%2")).arg(mNickname, mRoom.name);
+  mConnection->setLabel(label);
+  mOutbox.rename(label);
 }
 
 void ChatSession::start() {
-  if (mKeepaliveTimerId) {
-    killTimer(mKeepaliveTimerId);
+  // the login session may be shared with other rooms, which means that it
+  // logging back in on their behalf doesn't necessarily concern this one.
+  // unless of course this one is waiting to do the same.
+  if (mState == ConnectionState::Connecting ||
+      mState == ConnectionState::Connected) {
+    return;
+  }
+  mReconnectTimer.stop();
+  // conversations and pending messages are kept as they are when
+  // reconnecting, and so is everything waiting to be sent.
+  mState = ConnectionState::Connecting;
+  if (mSocketState == SocketState::Closed) {
+    openSocket();
+  } else if (mSocketState == SocketState::HelloReceived) {
+    sendLogin();
+  }
+  if (!mKeepaliveId) {
+    mKeepaliveId =
+        KeepaliveScheduler::instance().add([=]() { sendKeepalive(); });
   }
-  mCurrentPrivate.clear();
-  mHelloReceived = false;
-  mWebSocket->open(QUrl(mHost));
-  mKeepaliveTimerId = startTimer(keepaliveInterval);
 }
 
 void ChatSession::acceptPrivateConversation(const QString &nickname) {
@@ -233,105 +249,195 @@ void ChatSession::acceptPrivateConversation(const QString &nickname) {
 }
 
 void ChatSession::rejectPrivateConversation(const QString &nickname) {
-  SendTextMessage(mWebSocket, privRejectMsg(nickname));
+  sendText(mFrameWriter.privReject(nickname));
   mCurrentPrivate.remove(nickname);
 }
 
 void ChatSession::notifyPrivateConversationClosed(const QString &nickname) {
-  SendTextMessage(mWebSocket, privClosedMsg(nickname));
+  sendText(mFrameWriter.privClosed(nickname));
   mCurrentPrivate.remove(nickname);
 }
 
-void ChatSession::sendRoomMessage(const QString &message) {
+ChatSession::SendResult ChatSession::sendRoomMessage(const QString &message) {
+  if (!canSendNow()) {
+    // logged when actually sent.
+    return mOutbox.add(Outbox::Kind::Room, QString(), message)
+               ? SendResult::Queued
+               : SendResult::Resubmitted;
+  }
   mListener->onRoomMessage(
       this, Message(QDateTime::currentDateTime(), message, mNickname));
-  SendTextMessage(mWebSocket, messageMsg(message));
+  if (mPendingEchoes.size() == maxPendingEchoes) {
+    mPendingEchoes.pop_front();
+  }
+  mPendingEchoes.push_back({message, mEchoClock.elapsed()});
+  sendText(mFrameWriter.roomMessage(message));
+  return SendResult::Sent;
 }
 
-void ChatSession::sendPrivateMessage(const QString &nickname,
-                                     const QString &message) {
+ChatSession::SendResult
+ChatSession::sendPrivateMessage(const QString &nickname,
+                                const QString &message) {
+  if (!canSendNow()) {
+    return mOutbox.add(Outbox::Kind::Private, nickname, message)
+               ? SendResult::Queued
+               : SendResult::Resubmitted;
+  }
   mListener->onPrivateMessageSent(
       this, Message(QDateTime::currentDateTime(), message, nickname));
   auto it = mCurrentPrivate.find(nickname);
   if (it == std::end(mCurrentPrivate) ||
       it->mState == ConversationState::Rejected ||
       it->mState == ConversationState::Closed) {
-    SendTextMessage(mWebSocket, privInviteMsg(message, nickname));
+    sendText(mFrameWriter.privInvite(message, nickname));
     mCurrentPrivate[nickname].mState = ConversationState::InviteSent;
   } else if (it->mState == ConversationState::Active ||
              it->mState == ConversationState::InviteSent) {
-    SendTextMessage(mWebSocket, privMessageMsg(message, nickname));
+    sendText(mFrameWriter.privMessage(message, nickname));
   } else {
     Q_ASSERT(false && "unknown private conversation state");
   }
+  return SendResult::Sent;
 }
 
 void ChatSession::sendImage(const QString &nickname, const QImage &image) {
-  if (image.width() > 600 || image.height() > 600) {
-    // the website seems to scale images to be at most 600 pixels wide or high
-    // before actually sending them.
-    SendTextMessage(
-        mWebSocket,
-        privImageMsg(nickname, image.scaled(600, 600, Qt::KeepAspectRatio,
-                                            Qt::SmoothTransformation)));
-  } else {
-    SendTextMessage(mWebSocket, privImageMsg(nickname, image));
-  }
+  // the website seems to scale images to be at most 600 pixels wide or high
+  // before actually sending them. scaling and encoding take a while, so
+  // they're left to a worker thread.
+  auto job = new ImageEncodeJob(image, QSize(600, 600));
+  connect(job, &ImageEncodeJob::finished, this,
+          [=](int width, int height, const QByteArray &base64Jpeg) {
+            if (base64Jpeg.isEmpty()) {
+              qInfo() << "Could not encode the image sent to" << nickname;
+              return;
+            }
+            const auto &frame =
+                mFrameWriter.privImage(nickname, width, height, base64Jpeg);
+            mConnection->send(frame, OutboundQueue::Priority::Image);
+          });
+  job->start();
 }
 
-void ChatSession::timerEvent(QTimerEvent *ev) {
-  Q_ASSERT(ev->timerId() == mKeepaliveTimerId);
-  sendKeepalive();
-}
+void ChatSession::handleFrames(std::vector<InboundFrame> &frames) {
+  // a single large batch may just be the user list arriving, so shedding
+  // only kicks in once the session keeps falling behind.
+  mBacklog = 0.75 * mBacklog + 0.25 * static_cast<double>(frames.size());
+  mShedding = mBackgrounded &&
+              mDispatchPolicy.shedding != DispatchPolicy::Shedding::Off &&
+              mBacklog >= mDispatchPolicy.sheddingThreshold;
+
+  std::vector<InboundFrame *> order;
+  order.reserve(frames.size());
+  for (auto &&frame : frames) {
+    order.push_back(&frame);
+  }
+  // frames received before logging in are thrown away, save for the hello,
+  // so there's nothing to gain from reordering those.
+  if (mState == ConnectionState::Connected &&
+      static_cast<int>(frames.size()) >= mDispatchPolicy.priorityThreshold) {
+    std::stable_partition(std::begin(order), std::end(order),
+                          [=](auto frame) { return isUrgent(*frame); });
+  }
 
-void ChatSession::onTextMessageReceived(const QString &text) {
-  QJsonParseError err;
-  QJsonDocument json = QJsonDocument::fromJson(text.toUtf8(), &err);
-  if (json.isNull() || !json.isObject()) {
-    qInfo() << "Could not parse message" << err.errorString() << err.offset;
-    qInfo().noquote() << text;
-    return;
+  // handling a frame may well end up deleting the session, e.g. through a
+  // message box being shown.
+  QPointer<ChatSession> guard(this);
+  for (auto frame : order) {
+    handleFrame(*frame);
+    if (!guard) {
+      return;
+    }
   }
 
-  auto obj = json.object();
+  if (mShedMessages || mShedJoins || mShedParts) {
+    if (mDispatchPolicy.shedding == DispatchPolicy::Shedding::Summarize) {
+      emit eventsShed(mShedMessages, mShedJoins, mShedParts);
+    }
+    mShedMessages = mShedJoins = mShedParts = 0;
+  }
+}
 
-  emit_debug_line(obj, text, "<");
+bool ChatSession::isUrgent(const InboundFrame &frame) const {
+  // joins, parts and the user list are left in the order they came in, as
+  // the user list depends on it.
+  switch (frame.header.code) {
+  case 97:   /* private conversations */
+  case 150:  /* errors, kicks and bans */
+  case 200:  /* nick assigned */
+  case 1003: /* keepalive request */
+    return true;
+  default:
+    return false;
+  }
+}
 
-  auto code = obj[QLatin1String("code")].toInt();
-  if (!mHelloReceived) {
-    if (code != 138) {
-      qInfo() << "Received code" << code << "message while waiting for hello";
+void ChatSession::handleFrame(InboundFrame &frame) {
+  const auto &header = frame.header;
+  if (mState != ConnectionState::Connected &&
+      mSocketState == SocketState::LoginSent) {
+    // the user list is the first thing sent once the login is accepted.
+    // whatever comes before it is handled as usual, as it may well be an
+    // error or the nickname we were given.
+    if (header.code == 132) {
+      onLoginConfirmed();
+    }
+  } else if (mState != ConnectionState::Connected) {
+    if (header.code != 138) {
+      qInfo() << "Received code" << header.code
+              << "message while waiting for hello";
       return;
     }
-    SendTextMessage(mWebSocket,
-                    loginMsg(mLoginSession->sessionId(), channel(), mNickname));
-    mHelloReceived = true;
+    mSocketState = SocketState::HelloReceived;
+    // otherwise, still logging in. start() takes it from there.
+    if (mState == ConnectionState::Connecting) {
+      sendLogin();
+    }
     return;
   }
 
-  switch (code) {
+  if (frame.ignored) {
+    return;
+  }
+  if (!frame.decoded) {
+    reportUnhandled(frame.raw);
+    return;
+  }
+
+  switch (header.code) {
   case 129: {
-    auto msg = Message::roomMessage(obj);
+    const auto &msg = frame.message;
+    if (msg.nickname() == mNickname) {
+      matchEcho(msg);
+    } else if (!admitMessage(msg.nickname())) {
+      break;
+    }
     mListener->onRoomMessage(this, msg);
-    if (msg.nickname() != mNickname &&
-        !mBlocker.isUserBlocked(msg.nickname()) &&
-        !mBlocker.isMessageBlocked(msg.rawMessage())) {
-      emit roomMessageReceived(msg);
+    if (msg.nickname() != mNickname && !frame.userBlocked &&
+        !frame.messageBlocked) {
+      if (mShedding) {
+        ++mShedMessages;
+      } else {
+        emit roomMessageReceived(msg);
+      }
     }
     break;
   }
   case 128: {
-    auto users = obj[QLatin1String("users")].toArray();
-    for (auto &&user : users) {
-      const auto nickname = user.toObject()[QLatin1String("login")].toString();
-      emit userJoined(nickname);
-      mListener->onUserJoined(this, nickname);
+    auto &&joined = frame.users;
+    for (auto &&user : joined.users) {
+      if (mShedding) {
+        ++mShedJoins;
+      } else {
+        emit userJoined(user.mLogin);
+      }
+      mListener->onUserJoined(this, user.mLogin);
     }
-    mUserListModel->addUsers(users);
+    mUserListModel->addUsers(joined.users);
     break;
   }
   case 130: {
-    auto user = obj[QLatin1String("login")].toString();
+    auto &&user = frame.userLeft.login;
+    mUserListModel->removeUser(user);
     auto it = mCurrentPrivate.find(user);
     if (it != std::end(mCurrentPrivate)) {
       const auto lastState = it->mState;
@@ -340,89 +446,88 @@ void ChatSession::onTextMessageReceived(const QString &text) {
       if (lastState == Czateria::ConversationState::InviteReceived) {
         emit privateConversationCancelled(user);
       }
+      // whoever we were talking to is never left out.
+      emit userLeft(user);
+    } else if (mShedding) {
+      ++mShedParts;
+    } else {
+      emit userLeft(user);
     }
-    emit userLeft(user);
     mListener->onUserLeft(this, user);
     break;
   }
 
   case 97:
-    if (!handlePrivateMessage(obj)) {
-      reportUnhandled(text);
+    if (!handlePrivateMessage(frame)) {
+      reportUnhandled(frame.raw);
     }
     break;
 
   case 132: /* user list */
-    mUserListModel->setUserData(obj[QLatin1String("users")].toArray());
+    mUserListModel->setUserData(std::move(frame.users.users));
     break;
 
   case 183: /* extra user info */
-    mUserListModel->setCardData(obj[QLatin1String("cards")].toArray());
+    mUserListModel->setCardData(std::move(frame.cards.cards));
     break;
 
   case 137: /* user's priv state change */
-    mUserListModel->setPrivStatus(obj[QLatin1String("user")].toString(),
-                                  obj[QLatin1String("hasPrivs")].toInt());
+    mUserListModel->setPrivStatus(frame.privStatus.user,
+                                  frame.privStatus.hasPrivs);
     break;
 
   case 184: /* user info change */
-    mUserListModel->updateCardData(obj);
+    mUserListModel->updateCardData(frame.card);
     break;
 
   case 200: /* nick assigned : {"code":200,"username":"gość_15929765"} */
-    mNickname = obj[QLatin1String("username")].toString();
+    mNickname = frame.nickAssigned.username;
     mLoginSession->setNickname(mNickname);
     emit nicknameAssigned(mNickname);
     break;
 
   case 1003:
-    // server-sent keepalive request (every 4 minutes). reply immediately and
-    // reset the timer to fire every 40s from this point in time.
-    killTimer(mKeepaliveTimerId);
-    mKeepaliveTimerId = startTimer(keepaliveInterval);
+    // server-sent keepalive request (every 4 minutes). reply immediately,
+    // which also pushes our own next keepalive a full interval away.
+    KeepaliveScheduler::instance().noteServerRequest(mKeepaliveId);
     sendKeepalive();
     break;
 
-  case 150: {
-    auto subcode = obj[QLatin1String("subcode")].toInt();
+  case 150:
     // the exact meaning isn't known, but this is seemingly caused by a somehow
     // invalid nickname. the server stops processing any further messages after
     // this, so there's no point in keeping the session alive.
-    if (subcode == 1) {
+    if (header.subcode == 1) {
       emit sessionError();
-      break;
-    } else if (subcode == 26) {
-      handleKickBan(obj);
-      break;
+    } else if (header.subcode == 26) {
+      handleKickBan(frame.kickBan);
     }
-  }
-
-  case 135: /* advertisement / global message */
-    // {"code":135,"sender":"Redakcja","message":"foobar","url":"foobar\u0000"}
-  case 131: /* welcome / channel topic */
-    /* {"msgColorId":0,"msg":"foobar","msgFontTypeId":0,"msgIsBold":1,
-     * "code":131,"msgStyleId":1} */
-  case 134: /* userlist emoticon change :
-               {emoId:1,code:134,login:"foobar"} */
-  case 140: /* ?! {"user":"foobar","permission":65,"code":140} */
     break;
+
   default:
-    reportUnhandled(text);
+    reportUnhandled(frame.raw);
     break;
   }
 }
 
-bool ChatSession::handlePrivateMessage(const QJsonObject &json) {
-  const auto user = json[QLatin1String("user")].toString();
-  const auto subcode = json[QLatin1String("subcode")].toInt();
-  const auto userBlocked = mBlocker.isUserBlocked(user);
+bool ChatSession::handlePrivateMessage(InboundFrame &frame) {
+  const auto &event = frame.privateEvent;
+  const auto &user = event.user;
+  const auto subcode = event.subcode;
+  const auto userBlocked = frame.userBlocked;
   const auto it = mCurrentPrivate.find(user);
 
   if (subcode == 1 || subcode == 2) {
-    // incoming message
-    auto msg = Message::privMessage(json);
+    // incoming message. conversations we've accepted are left alone, as
+    // whoever we're talking to is obviously welcome to.
+    const auto accepted = it != std::end(mCurrentPrivate) &&
+                          it->mState == ConversationState::Active;
+    if (!accepted && !admitMessage(user)) {
+      return true;
+    }
+    const auto &msg = frame.message;
     mListener->onPrivateMessageReceived(this, msg);
-    if (mBlocker.isMessageBlocked(msg.rawMessage()) || userBlocked) {
+    if (frame.messageBlocked || userBlocked) {
       return true;
     }
 
@@ -430,7 +535,7 @@ bool ChatSession::handlePrivateMessage(const QJsonObject &json) {
         it->mState == ConversationState::Closed) {
       auto &ctx = mCurrentPrivate[user];
       ctx.mState = ConversationState::InviteReceived;
-      ctx.mPendingMessages.push_back(msg);
+      addPendingMessage(ctx, msg);
       emit newPrivateConversation(user);
     } else {
       const auto state = it->mState;
@@ -440,7 +545,7 @@ bool ChatSession::handlePrivateMessage(const QJsonObject &json) {
       } else if (state == ConversationState::Active) {
         emit privateMessageReceived(msg);
       } else if (state == ConversationState::InviteReceived) {
-        it->mPendingMessages.push_back(msg);
+        addPendingMessage(*it, msg);
       } else {
         Q_ASSERT(false && "unknown state in handlePrivateMessage");
         return false;
@@ -463,20 +568,15 @@ bool ChatSession::handlePrivateMessage(const QJsonObject &json) {
     emit privateConversationCancelled(user);
     return true;
   } else if (subcode == 25) {
-    auto b64img = json[QLatin1String("data")].toString();
-    if (b64img.isNull()) {
+    if (event.data.isNull()) {
       qInfo() << "Received subcode 25 without a 'data' element";
       return false;
     }
-    auto originalData = QByteArray::fromBase64(b64img.toLatin1());
-    QBuffer buf(&originalData);
-    buf.open(QIODevice::ReadOnly);
-    auto format = QImageReader::imageFormat(&buf);
-    if (format.isEmpty()) {
+    if (frame.imageFormat.isEmpty()) {
       qInfo() << "Could not decode base64 content as image";
       return false;
     }
-    emit imageReceived(user, originalData, format);
+    emit imageReceived(user, frame.image, frame.imageFormat);
     return true;
   } else if (subcode == 26) {
     /* image delivery confirmation. not really that useful. generated by the
@@ -496,7 +596,7 @@ bool ChatSession::handlePrivateMessage(const QJsonObject &json) {
   "msgStyleId": 0,
   "nickColorId": 71,
   "code": 97 } */
-    emit imageDelivered(json[QLatin1String("user")].toString());
+    emit imageDelivered(user);
     return true;
   }
   bool ok;
@@ -509,29 +609,154 @@ bool ChatSession::handlePrivateMessage(const QJsonObject &json) {
   return ok;
 } // namespace Czateria
 
-void ChatSession::onSocketError(QAbstractSocket::SocketError err) {
-  if (err == QAbstractSocket::RemoteHostClosedError) {
-    if (mHelloReceived) {
-      if (mLoginSession->restart(mRoom)) {
-        qInfo() << "Connection closed by server, trying to reconnect";
-      } else {
-        emit sessionExpired();
-      }
-    }
+void ChatSession::matchEcho(const Message &msg) {
+  // the server echoes messages in the order they were sent, but whatever it
+  // drops never comes back, so anything older than a match is given up on.
+  const auto &text = msg.rawMessage();
+  auto it = std::find_if(std::begin(mPendingEchoes), std::end(mPendingEchoes),
+                         [&](auto &&echo) { return echo.text == text; });
+  if (it == std::end(mPendingEchoes)) {
+    return;
+  }
+  const auto rtt = mEchoClock.elapsed() - it->sentAt;
+  mPendingEchoes.erase(std::begin(mPendingEchoes), std::next(it));
+  if (rtt <= maxEchoWait) {
+    mConnection->metrics().echoRtt.add(rtt);
+    emit roundTripMeasured(rtt);
+  }
+}
+
+bool ChatSession::admitMessage(const QString &nickname) {
+  const auto verdict = mFloodGuard.admit(nickname);
+  if (verdict == FloodGuard::Verdict::Admitted) {
+    return true;
+  }
+  if (!mFloodReportTimer.isActive()) {
+    mFloodReportTimer.start();
+  }
+  if (verdict == FloodGuard::Verdict::Flooding) {
+    qInfo() << nickname << "is flooding" << channel();
+    emit floodDetected(nickname);
+  }
+  return false;
+}
+
+void ChatSession::reportSuppressedMessages() {
+  const auto suppressed = mFloodGuard.takeSuppressed();
+  if (suppressed.isEmpty()) {
+    mFloodReportTimer.stop();
+    return;
+  }
+  for (auto it = suppressed.cbegin(); it != suppressed.cend(); ++it) {
+    qInfo() << it.value() << "messages from" << it.key() << "suppressed on"
+            << channel();
+    emit messagesSuppressed(it.key(), it.value());
+  }
+}
+
+void ChatSession::onSocketError(QAbstractSocket::SocketError err,
+                                const QString &errorString) {
+  const auto loginSent = mSocketState == SocketState::LoginSent;
+  mSocketState = SocketState::Closed;
+  mConnectionStalled = false;
+  if (mState == ConnectionState::WaitingToReconnect) {
+    // the socket's already gone, the reconnect will take care of it.
+    return;
+  }
+  if (mState == ConnectionState::Reconnecting) {
+    // start() opens another one once logged back in.
+    qInfo() << "Connection failed while logging back in :" << errorString;
+    return;
+  }
+  // a connection dropped right after logging in counts as a failed attempt,
+  // so that the delays keep growing for as long as that goes on.
+  const auto reconnecting = mState == ConnectionState::Connecting &&
+                            (mReconnectAttempts > 0 || loginSent);
+  if ((mState == ConnectionState::Connected || reconnecting) &&
+      isErrorTransient(err)) {
+    qInfo() << "Connection lost :" << errorString;
+    scheduleReconnect();
+  } else if (err == QAbstractSocket::RemoteHostClosedError) {
+    // closed before even saying hello. nothing to be done about it.
   } else {
-    qInfo() << "Socket error" << err << mWebSocket->errorString();
+    qInfo() << "Socket error" << err << errorString;
     emit sessionError();
   }
 }
 
+void ChatSession::scheduleReconnect() {
+  if (!mLoginSession->canRestart() ||
+      mReconnectAttempts >= maxReconnectAttempts) {
+    mState = ConnectionState::Idle;
+    emit sessionExpired();
+    return;
+  }
+  mState = ConnectionState::WaitingToReconnect;
+  mConnection->setHeld(true);
+  const auto delay = reconnectDelay(mReconnectAttempts++);
+  qInfo() << "Reconnecting in" << delay << "ms";
+  mReconnectTimer.start(delay);
+}
+
+void ChatSession::openSocket() {
+  mSocketState = SocketState::Opening;
+  mConnection->open();
+}
+
+void ChatSession::sendLogin() {
+  mConnection->send(
+      mFrameWriter.login(mLoginSession->sessionId(), channel(), mNickname),
+      OutboundQueue::Priority::Control);
+  // the server may still turn the login down, or drop the connection, so
+  // nothing else goes out until it's accepted.
+  mSocketState = SocketState::LoginSent;
+}
+
+void ChatSession::onLoginConfirmed() {
+  mState = ConnectionState::Connected;
+  mReconnectAttempts = 0;
+  mConnection->setHeld(false);
+  flushOutbox();
+}
+
+void ChatSession::flushOutbox() {
+  if (mOutbox.isEmpty()) {
+    return;
+  }
+  int expired;
+  const auto items = mOutbox.take(expired);
+  for (auto &&item : items) {
+    switch (item.kind) {
+    case Outbox::Kind::Room:
+      sendRoomMessage(item.text);
+      break;
+    case Outbox::Kind::Private:
+      sendPrivateMessage(item.nickname, item.text);
+      break;
+    }
+  }
+  if (!items.empty()) {
+    emit outboxSent(static_cast<int>(items.size()));
+  }
+  if (expired > 0) {
+    qInfo() << "Dropped" << expired << "outbox messages of" << mNickname
+            << "in" << mRoom.name << "which waited too long";
+    emit outboxExpired(expired);
+  }
+}
+
+void ChatSession::sendText(const QString &frame) {
+  mConnection->send(frame, OutboundQueue::Priority::Text);
+}
+
 void ChatSession::sendKeepalive() {
-  SendTextMessage(mWebSocket, keepaliveMsg());
+  mConnection->send(FrameWriter::keepalive(),
+                    OutboundQueue::Priority::Control);
 }
 
-void ChatSession::handleKickBan(const QJsonObject &json) {
-  auto adminNickname = json[QLatin1String("admin")].toString();
-  auto type = json[QLatin1String("type")].toInt();
-  switch (type) {
+void ChatSession::handleKickBan(const KickBanFrame &kickBan) {
+  auto &&adminNickname = kickBan.admin;
+  switch (kickBan.type) {
   case 9:
     emit kicked(BlockCause::Nick);
     break;
@@ -574,11 +799,30 @@ void ChatSession::onBlockerChanged() {
   }
 }
 
+void ChatSession::addPendingMessage(PrivConvContext &ctx,
+                                    const Message &msg) {
+  if (!ctx.mPendingMessages) {
+    ctx.mPendingMessages = std::make_shared<PendingMessages>();
+  }
+  ctx.mPendingMessages->push(msg);
+}
+
 void ChatSession::emitPendingMessages(PrivConvHash::iterator it) {
-  for (auto &&msg : it->mPendingMessages) {
+  if (!it->mPendingMessages) {
+    return;
+  }
+  // everything's taken out before emitting anything, as whoever's on the
+  // receiving end may well change the conversations.
+  int dropped;
+  const auto nickname = it.key();
+  const auto messages = it->mPendingMessages->takeAll(dropped);
+  it->mPendingMessages.reset();
+  if (dropped) {
+    emit pendingMessagesDropped(nickname, dropped);
+  }
+  for (auto &&msg : messages) {
     emit privateMessageReceived(msg);
   }
-  it->mPendingMessages.clear();
 }
 
 } // namespace Czateria
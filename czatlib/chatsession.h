@@ -2,18 +2,28 @@
 #define CHATSESSION_H
 
 #include <QAbstractSocket>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QObject>
 #include <QSharedPointer>
 #include <QString>
+#include <QTimer>
+#include <QUrl>
+
+#include <deque>
+#include <memory>
+#include <vector>
 
 #include "conversationstate.h"
+#include "floodguard.h"
+#include "framewriter.h"
 #include "loginsession.h"
+#include "outboundqueue.h"
+#include "outbox.h"
 #include "room.h"
 
 class QByteArray;
-class QWebSocket;
-class QTimerEvent;
+class QThread;
 
 namespace Czateria {
 
@@ -23,6 +33,11 @@ class UserListModel;
 class AvatarHandler;
 class ChatBlocker;
 struct ChatSessionListener;
+class ChatConnection;
+struct InboundFrame;
+struct KickBanFrame;
+class SessionMetrics;
+class PendingMessages;
 
 class ChatSession : public QObject {
   Q_OBJECT
@@ -43,14 +58,52 @@ public:
     return it == std::end(mCurrentPrivate) || isStateOkayToSend(it->mState);
   }
 
-  void sendRoomMessage(const QString &message);
-  void sendPrivateMessage(const QString &nickname, const QString &message);
+  // messages sent while not connected wait in the outbox, and go out once
+  // the session is. a message which was queued a moment ago already isn't
+  // queued again.
+  enum class SendResult { Sent, Queued, Resubmitted };
+  SendResult sendRoomMessage(const QString &message);
+  SendResult sendPrivateMessage(const QString &nickname,
+                                const QString &message);
   void sendImage(const QString &nickname, const QImage &image);
 
   const QString &channel() const { return mRoom.name; }
   const QString &nickname() const { return mNickname; }
   UserListModel *userListModel() const { return mUserListModel; }
 
+  // returns the path of the written file, or a null string on failure.
+  QString dumpWireTrace(const QString &directory) const;
+  const SessionMetrics &metrics() const;
+  void setOutboundLimits(const OutboundQueue::Limits &limits);
+  void setFloodLimits(const FloodGuard::Limits &limits) {
+    mFloodGuard.setLimits(limits);
+  }
+  // handles a frame as if it was received from the server. used for replaying
+  // recorded sessions.
+  void replayFrame(const QByteArray &frame);
+
+  /* frames arrive in batches of whatever piled up since the last one was
+   * handled, so the size of a batch is a good measure of how far behind the
+   * session is. */
+  struct DispatchPolicy {
+    enum class Shedding { Off, Drop, Summarize };
+    // batches at least this large have private and control frames handled
+    // before everything else.
+    int priorityThreshold = 32;
+    // a session in the background stops emitting room messages, joins and
+    // parts while its batches average at least this many frames.
+    int sheddingThreshold = 256;
+    Shedding shedding = Shedding::Summarize;
+  };
+  void setDispatchPolicy(const DispatchPolicy &policy) {
+    mDispatchPolicy = policy;
+  }
+  // used for all sessions created afterwards.
+  static void setDefaultDispatchPolicy(const DispatchPolicy &policy);
+  static const DispatchPolicy &defaultDispatchPolicy();
+  // whether whatever displays the session is out of the user's sight.
+  void setBackgrounded(bool backgrounded) { mBackgrounded = backgrounded; }
+
   enum class BlockCause { Unknown, Nick, Behaviour, Avatar };
 
 signals:
@@ -61,6 +114,9 @@ signals:
   void privateConversationStateChanged(const QString &nickname,
                                        Czateria::ConversationState state);
   void privateMessageReceived(const Czateria::Message &msg);
+  // emitted right before the messages of a conversation which were received
+  // before accepting it, if some of them had to be dropped.
+  void pendingMessagesDropped(const QString &nickname, int count);
   void imageReceived(const QString &nickname, const QByteArray &data,
                      const QByteArray &format);
   void imageDelivered(const QString &nickname);
@@ -71,9 +127,24 @@ signals:
   void banned(Czateria::ChatSession::BlockCause why,
               const QString &adminNickname);
   void kicked(Czateria::ChatSession::BlockCause why);
-
-protected:
-  void timerEvent(QTimerEvent *) override;
+  // what was left out of a batch handled while shedding, with the Summarize
+  // policy.
+  void eventsShed(int messages, int joins, int parts);
+  // room and private messages from senders going over the flood limits are
+  // left out entirely, and only reported every now and then.
+  void messagesSuppressed(const QString &nickname, int count);
+  void floodDetected(const QString &nickname);
+  // one of our room messages came back from the server.
+  void roundTripMeasured(qint64 msecs);
+  // messages typed while disconnected which waited too long to be sent, and
+  // were dropped instead.
+  void outboxExpired(int count);
+  // messages which waited in the outbox, sent now that the session is
+  // connected.
+  void outboxSent(int count);
+  // something we sent never left, as too much was already waiting to be
+  // sent.
+  void sendDropped(bool image);
 
 private:
   static bool isStateOkayToSend(ConversationState s) {
@@ -88,31 +159,92 @@ private:
       return false;
     }
   }
-  void onTextMessageReceived(const QString &);
-  bool handlePrivateMessage(const QJsonObject &json);
-  void onSocketError(QAbstractSocket::SocketError);
+  void handleFrames(std::vector<InboundFrame> &frames);
+  bool isUrgent(const InboundFrame &frame) const;
+  void handleFrame(InboundFrame &frame);
+  bool handlePrivateMessage(InboundFrame &frame);
+  bool admitMessage(const QString &nickname);
+  void reportSuppressedMessages();
+  void onSocketError(QAbstractSocket::SocketError err,
+                     const QString &errorString);
+  void scheduleReconnect();
+  void openSocket();
+  void sendLogin();
+  void onLoginConfirmed();
+  void sendText(const QString &frame);
   void sendKeepalive();
-  void handleKickBan(const QJsonObject &json);
+  void handleKickBan(const KickBanFrame &kickBan);
   void emitPendingMessages(const QString &);
   void onBlockerChanged();
+  void updateWireTraceLabel();
+  void matchEcho(const Message &msg);
 
-  QWebSocket *const mWebSocket;
+  FrameWriter mFrameWriter;
   QString mNickname;
-  const QString mHost;
-  bool mHelloReceived;
-  int mKeepaliveTimerId = 0;
+  const QUrl mHost;
+  // null if the connection runs on this thread.
+  QThread *mThread = nullptr;
+  ChatConnection *mConnection = nullptr;
+  int mKeepaliveId = 0;
+
+  enum class ConnectionState {
+    Idle,
+    Connecting, // logged in, waiting for hello and for the server to accept
+                // our login
+    Connected,
+    WaitingToReconnect,
+    Reconnecting // logging back in
+  };
+  ConnectionState mState = ConnectionState::Idle;
+  // the socket is opened while still logging in whenever possible, so it has
+  // a state of its own.
+  enum class SocketState { Closed, Opening, HelloReceived, LoginSent };
+  SocketState mSocketState = SocketState::Closed;
+  int mReconnectAttempts = 0;
+  QTimer mReconnectTimer;
   UserListModel *const mUserListModel;
   QSharedPointer<Czateria::LoginSession> mLoginSession;
   const Room mRoom;
   const ChatBlocker &mBlocker;
   ChatSessionListener *const mListener;
 
+  DispatchPolicy mDispatchPolicy;
+  double mBacklog = 0;
+  bool mBackgrounded = false;
+  bool mShedding = false;
+  int mShedMessages = 0;
+  int mShedJoins = 0;
+  int mShedParts = 0;
+
+  FloodGuard mFloodGuard;
+  QTimer mFloodReportTimer;
+
+  // room messages sent, along with when that happened, until the server
+  // echoes them back.
+  struct PendingEcho {
+    QString text;
+    qint64 sentAt;
+  };
+  std::deque<PendingEcho> mPendingEchoes;
+  QElapsedTimer mEchoClock;
+
+  Outbox mOutbox;
+  void flushOutbox();
+  // while the connection is stalled, it may already be dead without anyone
+  // knowing yet, so messages wait in the outbox rather than risk being lost.
+  bool mConnectionStalled = false;
+  bool canSendNow() const {
+    return mState == ConnectionState::Connected && !mConnectionStalled;
+  }
+
   struct PrivConvContext {
     ConversationState mState;
-    QVector<Message> mPendingMessages;
+    // only there while the conversation has any.
+    std::shared_ptr<PendingMessages> mPendingMessages;
   };
   using PrivConvHash = QHash<QString, PrivConvContext>;
   PrivConvHash mCurrentPrivate;
+  void addPendingMessage(PrivConvContext &ctx, const Message &msg);
   void emitPendingMessages(PrivConvHash::iterator);
 };
 
@@ -11,10 +11,30 @@ SOURCES += room.cpp \
     captcha.cpp \
     loginsession.cpp \
     chatsession.cpp \
+    chatconnection.cpp \
+    endpoints.cpp \
+    floodguard.cpp \
+    framedecoder.cpp \
+    framewriter.cpp \
+    imageencoder.cpp \
+    imagepayloadcache.cpp \
+    joinscheduler.cpp \
+    jsonreader.cpp \
+    keepalivescheduler.cpp \
     message.cpp \
+    outboundqueue.cpp \
+    outbox.cpp \
+    pendingconnections.cpp \
+    pendingmessages.cpp \
+    sessionmanager.cpp \
+    sessionmetrics.cpp \
+    sessionrecording.cpp \
+    sessionthreads.cpp \
+    tlssessioncache.cpp \
     user.cpp \
     userlistmodel.cpp \
-    icons.cpp
+    icons.cpp \
+    wiretrace.cpp
 
 HEADERS += room.h \
   chatblocker.h \
@@ -24,10 +44,30 @@ HEADERS += room.h \
     captcha.h \
     loginsession.h \
     chatsession.h \
+    chatconnection.h \
+    endpoints.h \
+    floodguard.h \
+    framedecoder.h \
+    framewriter.h \
+    imageencoder.h \
+    imagepayloadcache.h \
+    joinscheduler.h \
+    jsonreader.h \
+    keepalivescheduler.h \
     message.h \
+    outboundqueue.h \
+    outbox.h \
+    pendingconnections.h \
+    pendingmessages.h \
+    sessionmanager.h \
+    sessionmetrics.h \
+    sessionrecording.h \
+    sessionthreads.h \
+    tlssessioncache.h \
     user.h \
     userlistmodel.h \
     icons.h \
     conversationstate.h \
     util.h \
-    avatarhandler.h
+    avatarhandler.h \
+    wiretrace.h
@@ -0,0 +1,46 @@
+#include "endpoints.h"
+
+namespace {
+QString fromEnvironment(const char *name, QLatin1String defaultValue) {
+  return qEnvironmentVariableIsSet(name)
+             ? QString::fromLocal8Bit(qgetenv(name))
+             : QString(defaultValue);
+}
+
+const QString &wwwBase() {
+  static const QString base = fromEnvironment(
+      "CZATERIA_WWW_URL", QLatin1String("https://czateria.interia.pl"));
+  return base;
+}
+
+const QString &apiBase() {
+  static const QString base = fromEnvironment(
+      "CZATERIA_API_URL", QLatin1String("https://czateria-api.interia.pl"));
+  return base;
+}
+
+const QString &chatServerTemplate() {
+  static const QString address =
+      fromEnvironment("CZATERIA_WS_URL",
+                      QLatin1String("wss://%1-proxy-czateria.interia.pl"));
+  return address;
+}
+} // namespace
+
+namespace Czateria {
+namespace Endpoints {
+
+QUrl roomList() { return QUrl(wwwBase() + QLatin1String("/rooms-list")); }
+
+QUrl userLogin() { return QUrl(apiBase() + QLatin1String("/scp/user/login")); }
+
+QUrl guestLogin() { return QUrl(apiBase() + QLatin1String("/scp/user/guest")); }
+
+QString captcha() { return apiBase() + QLatin1String("/captcha/"); }
+
+QUrl chatServer(const QString &roomPort) {
+  return QUrl(chatServerTemplate().arg(roomPort));
+}
+
+} // namespace Endpoints
+} // namespace Czateria
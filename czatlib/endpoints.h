@@ -0,0 +1,27 @@
+#ifndef ENDPOINTS_H
+#define ENDPOINTS_H
+
+#include <QString>
+#include <QUrl>
+
+namespace Czateria {
+
+/* addresses of the services the client talks to. each one can be overridden
+ * with an environment variable, which is mostly useful for pointing the client
+ * at the mock server :
+ *  CZATERIA_WWW_URL - base address of the website, serving the room list
+ *  CZATERIA_API_URL - base address of the login and captcha API
+ *  CZATERIA_WS_URL  - chat server address, with %1 standing for the room's
+ *                     port */
+namespace Endpoints {
+QUrl roomList();
+QUrl userLogin();
+QUrl guestLogin();
+// returned as a string, as the caller needs to fill in the query.
+QString captcha();
+QUrl chatServer(const QString &roomPort);
+} // namespace Endpoints
+
+} // namespace Czateria
+
+#endif // ENDPOINTS_H
@@ -0,0 +1,86 @@
+#include "floodguard.h"
+
+#include <algorithm>
+
+namespace {
+Czateria::FloodGuard::Limits &defaultLimitsStorage() {
+  static Czateria::FloodGuard::Limits limits;
+  return limits;
+}
+} // namespace
+
+namespace Czateria {
+
+constexpr int FloodGuard::minPruneAt;
+
+FloodGuard::FloodGuard() : mLimits(defaultLimits()) { mClock.start(); }
+
+FloodGuard::Verdict FloodGuard::admit(const QString &nickname) {
+  if (mLimits.messagesPerSecond <= 0) {
+    return Verdict::Admitted;
+  }
+  const auto now = mClock.elapsed();
+  auto it = mSenders.find(nickname);
+  if (it == std::end(mSenders)) {
+    it = mSenders.insert(
+        nickname, {static_cast<double>(mLimits.burst), now, 0, 0});
+  } else {
+    refill(*it, now);
+  }
+  if (it->tokens >= 1) {
+    it->tokens -= 1;
+    it->suppressedInFlood = 0;
+    if (mSenders.size() >= mPruneAt) {
+      prune();
+    }
+    return Verdict::Admitted;
+  }
+  ++it->suppressed;
+  ++it->suppressedInFlood;
+  return it->suppressedInFlood == mLimits.floodThreshold ? Verdict::Flooding
+                                                         : Verdict::Suppressed;
+}
+
+QHash<QString, int> FloodGuard::takeSuppressed() {
+  QHash<QString, int> rv;
+  for (auto it = mSenders.begin(); it != mSenders.end(); ++it) {
+    if (it->suppressed) {
+      rv.insert(it.key(), it->suppressed);
+      it->suppressed = 0;
+    }
+  }
+  return rv;
+}
+
+void FloodGuard::setDefaultLimits(const Limits &limits) {
+  defaultLimitsStorage() = limits;
+}
+
+const FloodGuard::Limits &FloodGuard::defaultLimits() {
+  return defaultLimitsStorage();
+}
+
+void FloodGuard::refill(Sender &sender, qint64 now) const {
+  sender.tokens = std::min(static_cast<double>(mLimits.burst),
+                           sender.tokens + (now - sender.lastRefill) *
+                                               mLimits.messagesPerSecond /
+                                               1000.0);
+  sender.lastRefill = now;
+}
+
+void FloodGuard::prune() {
+  // a sender with a full bucket and nothing left to report is no different
+  // from one who's never been seen.
+  const auto now = mClock.elapsed();
+  for (auto it = mSenders.begin(); it != mSenders.end();) {
+    refill(*it, now);
+    if (it->suppressed == 0 && it->tokens >= mLimits.burst) {
+      it = mSenders.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  mPruneAt = std::max(minPruneAt, 2 * mSenders.size());
+}
+
+} // namespace Czateria
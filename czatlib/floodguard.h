@@ -0,0 +1,60 @@
+#ifndef FLOODGUARD_H
+#define FLOODGUARD_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+namespace Czateria {
+
+/* a token bucket per sender. messages from someone who ran out of tokens are
+ * counted rather than handled, and whoever keeps going long enough past that
+ * is reported as flooding. senders who've calmed down are forgotten. */
+class FloodGuard {
+public:
+  struct Limits {
+    // a rate of 0 disables the guard altogether.
+    double messagesPerSecond = 0.5;
+    int burst = 8;
+    // the number of messages suppressed in a row after which the sender is
+    // reported as flooding. 0 never reports anyone.
+    int floodThreshold = 40;
+  };
+
+  enum class Verdict { Admitted, Suppressed, Flooding };
+
+  FloodGuard();
+
+  // Flooding is returned once per flood. the message itself is suppressed.
+  Verdict admit(const QString &nickname);
+  // the number of messages suppressed per sender since the last call.
+  QHash<QString, int> takeSuppressed();
+
+  const Limits &limits() const { return mLimits; }
+  void setLimits(const Limits &limits) { mLimits = limits; }
+  // used for all guards created afterwards.
+  static void setDefaultLimits(const Limits &limits);
+  static const Limits &defaultLimits();
+
+private:
+  struct Sender {
+    double tokens;
+    qint64 lastRefill;
+    int suppressed;
+    int suppressedInFlood;
+  };
+
+  void refill(Sender &sender, qint64 now) const;
+  void prune();
+
+  Limits mLimits;
+  QHash<QString, Sender> mSenders;
+  int mPruneAt = minPruneAt;
+  QElapsedTimer mClock;
+
+  static constexpr int minPruneAt = 64;
+};
+
+} // namespace Czateria
+
+#endif // FLOODGUARD_H
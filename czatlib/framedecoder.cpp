@@ -0,0 +1,225 @@
+#include "framedecoder.h"
+
+#include "jsonreader.h"
+
+namespace {
+using namespace Czateria;
+
+QDate readDate(JsonReader &r) {
+  QString str;
+  r.read(str);
+  return QDate::fromString(str, QLatin1String("dd-MM-yyyy"));
+}
+
+UserCard::Sex readSex(JsonReader &r) {
+  QString str;
+  r.read(str);
+  return UserCard::sexFromString(str);
+}
+
+// clang-format off
+const JsonFieldTable<User, 5> userFields = {{
+  {QLatin1String("login"), [](JsonReader &r, User &u) { r.read(u.mLogin); }},
+  {QLatin1String("emotion"), [](JsonReader &r, User &u) { r.read(u.mEmotion); }},
+  {QLatin1String("isMobileUser"), [](JsonReader &r, User &u) { r.read(u.mMobileUser); }},
+  {QLatin1String("privs"), [](JsonReader &r, User &u) {
+     int privs;
+     r.read(privs);
+     u.mHasPrivs = privs > 0;
+   }},
+  {QLatin1String("perm"), [](JsonReader &r, User &u) {
+     int perm;
+     r.read(perm);
+     u.mType = User::typeFromPerm(perm);
+   }},
+}};
+
+const JsonFieldTable<UserCard, 12> cardFields = {{
+  {QLatin1String("userName"), [](JsonReader &r, UserCard &c) { r.read(c.mUserName); }},
+  {QLatin1String("description"), [](JsonReader &r, UserCard &c) { r.read(c.mDescription); }},
+  {QLatin1String("avatarId"), [](JsonReader &r, UserCard &c) { r.read(c.mAvatarId); }},
+  {QLatin1String("bornDate"), [](JsonReader &r, UserCard &c) { c.mBirthDate = readDate(r); }},
+  {QLatin1String("uid"), [](JsonReader &r, UserCard &c) { r.read(c.mUid); }},
+  {QLatin1String("lat"), [](JsonReader &r, UserCard &c) { r.read(c.mLatitude); }},
+  {QLatin1String("lon"), [](JsonReader &r, UserCard &c) { r.read(c.mLongitude); }},
+  {QLatin1String("token"), [](JsonReader &r, UserCard &c) { r.read(c.mToken); }},
+  {QLatin1String("searchAgeFrom"), [](JsonReader &r, UserCard &c) { r.read(c.mAgeFrom); }},
+  {QLatin1String("searchAgeTo"), [](JsonReader &r, UserCard &c) { r.read(c.mAgeTo); }},
+  {QLatin1String("sex"), [](JsonReader &r, UserCard &c) { c.mSex = readSex(r); }},
+  {QLatin1String("searchSex"), [](JsonReader &r, UserCard &c) { c.mSearchSex = readSex(r); }},
+}};
+
+const JsonFieldTable<UserListFrame, 1> userListFields = {{
+  {QLatin1String("users"), [](JsonReader &r, UserListFrame &f) { readArray(r, f.users, userFields); }},
+}};
+
+const JsonFieldTable<UserCardsFrame, 1> userCardsFields = {{
+  {QLatin1String("cards"), [](JsonReader &r, UserCardsFrame &f) { readArray(r, f.cards, cardFields); }},
+}};
+
+const JsonFieldTable<UserLeftFrame, 1> userLeftFields = {{
+  {QLatin1String("login"), [](JsonReader &r, UserLeftFrame &f) { r.read(f.login); }},
+}};
+
+const JsonFieldTable<PrivStatusFrame, 2> privStatusFields = {{
+  {QLatin1String("user"), [](JsonReader &r, PrivStatusFrame &f) { r.read(f.user); }},
+  {QLatin1String("hasPrivs"), [](JsonReader &r, PrivStatusFrame &f) { r.read(f.hasPrivs); }},
+}};
+
+const JsonFieldTable<NickAssignedFrame, 1> nickAssignedFields = {{
+  {QLatin1String("username"), [](JsonReader &r, NickAssignedFrame &f) { r.read(f.username); }},
+}};
+
+const JsonFieldTable<KickBanFrame, 2> kickBanFields = {{
+  {QLatin1String("admin"), [](JsonReader &r, KickBanFrame &f) { r.read(f.admin); }},
+  {QLatin1String("type"), [](JsonReader &r, KickBanFrame &f) { r.read(f.type); }},
+}};
+
+const JsonFieldTable<PrivateEventFrame, 4> privateEventFields = {{
+  {QLatin1String("subcode"), [](JsonReader &r, PrivateEventFrame &f) { r.read(f.subcode); }},
+  {QLatin1String("user"), [](JsonReader &r, PrivateEventFrame &f) { r.read(f.user); }},
+  {QLatin1String("msg"), [](JsonReader &r, PrivateEventFrame &f) { r.read(f.msg); }},
+  {QLatin1String("data"), [](JsonReader &r, PrivateEventFrame &f) { r.readBase64(f.data); }},
+}};
+// clang-format on
+
+template <typename T, std::size_t N>
+bool decodeFrame(const QByteArray &frame, T &out,
+                 const JsonFieldTable<T, N> &fields) {
+  JsonReader reader(frame);
+  return reader.atObject() && readObject(reader, out, fields);
+}
+} // namespace
+
+namespace Czateria {
+
+bool FrameDecoder::peekHeader(const QByteArray &frame, FrameHeader &header) {
+  JsonReader reader(frame);
+  if (!reader.beginObject()) {
+    return false;
+  }
+  bool codeFound = false, subcodeFound = false;
+  QLatin1String key(nullptr);
+  while (!(codeFound && subcodeFound) && reader.nextMember(key)) {
+    if (key == QLatin1String("code")) {
+      reader.read(header.code);
+      codeFound = true;
+    } else if (key == QLatin1String("subcode")) {
+      reader.read(header.subcode);
+      subcodeFound = true;
+    } else {
+      reader.skipValue();
+    }
+  }
+  return codeFound && !reader.hasError();
+}
+
+bool FrameDecoder::isIgnored(const FrameHeader &header) {
+  switch (header.code) {
+  case 131: /* welcome / channel topic */
+    /* {"msgColorId":0,"msg":"foobar","msgFontTypeId":0,"msgIsBold":1,
+     * "code":131,"msgStyleId":1} */
+  case 134: /* userlist emoticon change :
+               {emoId:1,code:134,login:"foobar"} */
+  case 135: /* advertisement / global message */
+    // {"code":135,"sender":"Redakcja","message":"foobar","url":"foobar\u0000"}
+  case 140: /* ?! {"user":"foobar","permission":65,"code":140} */
+    return true;
+  case 150:
+    return header.subcode != 1 && header.subcode != 26;
+  }
+  return false;
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, Message &roomMessage) {
+  // clang-format off
+  static const JsonFieldTable<Message, 2> roomMessageFields = {{
+    {QLatin1String("msg"), [](JsonReader &r, Message &m) { r.read(m.mRawMessageUtf8); }},
+    {QLatin1String("login"), [](JsonReader &r, Message &m) { r.read(m.mNickname); }},
+  }};
+  // clang-format on
+  roomMessage.mReceivedAt = QDateTime::currentDateTime();
+  return decodeFrame(frame, roomMessage, roomMessageFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, UserListFrame &out) {
+  return decodeFrame(frame, out, userListFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, UserCardsFrame &out) {
+  return decodeFrame(frame, out, userCardsFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, UserCard &out) {
+  return decodeFrame(frame, out, cardFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, UserLeftFrame &out) {
+  return decodeFrame(frame, out, userLeftFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, PrivStatusFrame &out) {
+  return decodeFrame(frame, out, privStatusFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, NickAssignedFrame &out) {
+  return decodeFrame(frame, out, nickAssignedFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, KickBanFrame &out) {
+  return decodeFrame(frame, out, kickBanFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, PrivateEventFrame &out) {
+  return decodeFrame(frame, out, privateEventFields);
+}
+
+bool FrameDecoder::decode(const QByteArray &frame, InboundFrame &out) {
+  out.raw = frame;
+  if (!peekHeader(frame, out.header)) {
+    return false;
+  }
+  if (isIgnored(out.header)) {
+    out.ignored = true;
+    return true;
+  }
+  switch (out.header.code) {
+  case 129:
+    out.decoded = decode(frame, out.message);
+    break;
+  case 128:
+  case 132:
+    out.decoded = decode(frame, out.users);
+    break;
+  case 130:
+    out.decoded = decode(frame, out.userLeft);
+    break;
+  case 97:
+    out.decoded = decode(frame, out.privateEvent);
+    break;
+  case 183:
+    out.decoded = decode(frame, out.cards);
+    break;
+  case 137:
+    out.decoded = decode(frame, out.privStatus);
+    break;
+  case 184:
+    out.decoded = decode(frame, out.card);
+    break;
+  case 200:
+    out.decoded = decode(frame, out.nickAssigned);
+    break;
+  case 150:
+    // only subcodes 1 and 26 get this far, see isIgnored().
+    out.decoded = out.header.subcode != 26 || decode(frame, out.kickBan);
+    break;
+  case 138:
+  case 1003:
+    // nothing in there apart from the code.
+    out.decoded = true;
+    break;
+  }
+  return true;
+}
+
+} // namespace Czateria
@@ -0,0 +1,108 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <vector>
+
+#include "message.h"
+#include "user.h"
+
+namespace Czateria {
+
+/* typed representations of the messages received from the server, filled
+ * directly from the raw frame without going through QJsonDocument. */
+
+struct FrameHeader {
+  int code = 0;
+  int subcode = 0;
+};
+
+struct UserListFrame { // codes 128 and 132
+  std::vector<User> users;
+};
+
+struct UserCardsFrame { // code 183
+  std::vector<UserCard> cards;
+};
+
+struct UserLeftFrame { // code 130
+  QString login;
+};
+
+struct PrivStatusFrame { // code 137
+  QString user;
+  int hasPrivs = 0;
+};
+
+struct NickAssignedFrame { // code 200
+  QString username;
+};
+
+struct KickBanFrame { // code 150
+  QString admin;
+  int type = 0;
+};
+
+struct PrivateEventFrame { // code 97
+  int subcode = 0;
+  QString user;
+  QByteArray msg; // UTF-8
+  QByteArray data; // base64 decoded already
+};
+
+/* a frame decoded according to its code, with only the members corresponding
+ * to that code filled in. */
+struct InboundFrame {
+  FrameHeader header;
+  QByteArray raw;
+  // the frame is known, but carries nothing we're interested in.
+  bool ignored = false;
+  // the code is known and the frame was decoded successfully.
+  bool decoded = false;
+  // room messages and private events only.
+  bool userBlocked = false;
+  bool messageBlocked = false;
+
+  // 129, and 97 with subcodes 1 and 2.
+  Message message;
+  UserListFrame users;
+  UserCardsFrame cards;
+  UserCard card;
+  UserLeftFrame userLeft;
+  PrivStatusFrame privStatus;
+  NickAssignedFrame nickAssigned;
+  KickBanFrame kickBan;
+  PrivateEventFrame privateEvent;
+  // 97 with subcode 25. the format is empty if the data isn't an image. the
+  // image shares its data with privateEvent.data.
+  QByteArray image;
+  QByteArray imageFormat;
+};
+
+class FrameDecoder {
+public:
+  // only looks for the code and subcode, skipping over everything else. this
+  // is enough to drop uninteresting messages without parsing them.
+  static bool peekHeader(const QByteArray &frame, FrameHeader &header);
+  // messages which are known, but carry nothing we're interested in.
+  static bool isIgnored(const FrameHeader &header);
+
+  static bool decode(const QByteArray &frame, Message &roomMessage);
+  static bool decode(const QByteArray &frame, UserListFrame &out);
+  static bool decode(const QByteArray &frame, UserCardsFrame &out);
+  static bool decode(const QByteArray &frame, UserCard &out);
+  static bool decode(const QByteArray &frame, UserLeftFrame &out);
+  static bool decode(const QByteArray &frame, PrivStatusFrame &out);
+  static bool decode(const QByteArray &frame, NickAssignedFrame &out);
+  static bool decode(const QByteArray &frame, KickBanFrame &out);
+  static bool decode(const QByteArray &frame, PrivateEventFrame &out);
+  // decodes whatever the frame's code says it is. returns false only if the
+  // header couldn't be read.
+  static bool decode(const QByteArray &frame, InboundFrame &out);
+};
+
+} // namespace Czateria
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,181 @@
+#include "framewriter.h"
+
+#include <QByteArray>
+
+#include "icons.h"
+
+namespace {
+bool needsEscaping(QChar c) {
+  return c.unicode() < 0x20 || c == QLatin1Char('"') ||
+         c == QLatin1Char('\\');
+}
+
+void appendEscaped(QString &out, QChar c) {
+  switch (c.unicode()) {
+  case '"':
+    out.append(QLatin1String("\\\""));
+    break;
+  case '\\':
+    out.append(QLatin1String("\\\\"));
+    break;
+  case '\b':
+    out.append(QLatin1String("\\b"));
+    break;
+  case '\f':
+    out.append(QLatin1String("\\f"));
+    break;
+  case '\n':
+    out.append(QLatin1String("\\n"));
+    break;
+  case '\r':
+    out.append(QLatin1String("\\r"));
+    break;
+  case '\t':
+    out.append(QLatin1String("\\t"));
+    break;
+  default:
+    out.append(QLatin1String("\\u00"));
+    out.append(QLatin1Char("0123456789abcdef"[(c.unicode() >> 4) & 0xF]));
+    out.append(QLatin1Char("0123456789abcdef"[c.unicode() & 0xF]));
+    break;
+  }
+}
+} // namespace
+
+namespace Czateria {
+
+void FrameWriter::begin(QLatin1String prefix) {
+  // the next frame most likely needs about as much room as the last one, so
+  // it's allocated once rather than grown piece by piece.
+  mBuffer.reserve(mLastSize);
+  mBuffer.append(prefix);
+}
+
+void FrameWriter::appendString(const QString &str) {
+  mBuffer.append(QLatin1Char('"'));
+  const auto begin = str.constData();
+  const auto end = begin + str.size();
+  auto chunkStart = begin;
+  for (auto p = begin; p != end; ++p) {
+    if (needsEscaping(*p)) {
+      mBuffer.append(chunkStart, static_cast<int>(p - chunkStart));
+      appendEscaped(mBuffer, *p);
+      chunkStart = p + 1;
+    }
+  }
+  mBuffer.append(chunkStart, static_cast<int>(end - chunkStart));
+  mBuffer.append(QLatin1Char('"'));
+}
+
+void FrameWriter::appendInt(int value) {
+  char buf[12];
+  auto p = buf + sizeof(buf);
+  auto v = value < 0 ? 0u - static_cast<unsigned>(value)
+                     : static_cast<unsigned>(value);
+  do {
+    *--p = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v);
+  if (value < 0) {
+    *--p = '-';
+  }
+  mBuffer.append(QLatin1String(p, static_cast<int>(buf + sizeof(buf) - p)));
+}
+
+void FrameWriter::appendMessageCommon(const QString &message) {
+  append(QLatin1String(",\"msg\":"));
+  appendString(textIconsToTags(message));
+  append(QLatin1String(",\"msgColorId\":0,\"msgFontTypeId\":0,"
+                       "\"msgIsBold\":false,\"msgIsItalic\":false,"
+                       "\"msgIsUnderline\":false"));
+}
+
+QString FrameWriter::finish() {
+  mBuffer.append(QLatin1Char('}'));
+  // the frame stays queued in the connection for a while, possibly on another
+  // thread, so it's handed over rather than shared with the next one.
+  QString frame;
+  frame.swap(mBuffer);
+  mLastSize = frame.size();
+  return frame;
+}
+
+QString FrameWriter::login(const QString &sessionId, const QString &channelName,
+                           const QString &nickname) {
+  begin(QLatin1String("{\"code\":108,\"login\":"));
+  appendString(nickname);
+  append(QLatin1String(",\"cryptLogin\":\"\",\"slowLogin\":false,"
+                       "\"sessionId\":"));
+  appendString(sessionId);
+  append(QLatin1String(",\"channelName\":"));
+  appendString(channelName);
+  append(QLatin1String(
+      ",\"localIp\":\"127.0.0.1\",\"nickColorId\":0,\"emotionId\":0,"
+      "\"cardDate\":\"0\",\"cardReasonId\":0,\"cardSex\":\"0\","
+      "\"cardDescription\":\"\",\"cardSearchSex\":\"0\","
+      "\"cardSearchAgeFrom\":0,\"cardSearchAgeTo\":0,\"isHiddenMode\":0,"
+      "\"lat\":0,\"lon\":0"));
+  return finish();
+}
+
+QString FrameWriter::roomMessage(const QString &message) {
+  begin(QLatin1String("{\"code\":1"));
+  appendMessageCommon(message);
+  return finish();
+}
+
+QString FrameWriter::privInvite(const QString &message,
+                                const QString &nickname) {
+  begin(QLatin1String("{\"code\":97,\"subcode\":1,\"user\":"));
+  appendString(nickname);
+  appendMessageCommon(message);
+  return finish();
+}
+
+QString FrameWriter::privMessage(const QString &message,
+                                 const QString &nickname) {
+  begin(QLatin1String("{\"code\":97,\"subcode\":2,\"user\":"));
+  appendString(nickname);
+  appendMessageCommon(message);
+  return finish();
+}
+
+QString FrameWriter::privReject(const QString &nickname) {
+  begin(QLatin1String("{\"code\":97,\"subcode\":13,\"user\":"));
+  appendString(nickname);
+  return finish();
+}
+
+QString FrameWriter::privClosed(const QString &nickname) {
+  begin(QLatin1String("{\"code\":97,\"subcode\":14,\"user\":"));
+  appendString(nickname);
+  return finish();
+}
+
+QString FrameWriter::privImage(const QString &nickname, int width, int height,
+                               const QByteArray &base64Jpeg) {
+  begin(QLatin1String("{\"code\":97,\"subcode\":25,\"user\":"));
+  appendString(nickname);
+  append(QLatin1String(",\"type\":1,\"imgWidth\":"));
+  appendInt(width);
+  append(QLatin1String(",\"imgHeight\":"));
+  appendInt(height);
+  append(QLatin1String(",\"data\":\""));
+  // base64 never needs escaping.
+  mBuffer.reserve(mBuffer.size() + base64Jpeg.size() + 2);
+  append(QLatin1String(base64Jpeg.constData(), base64Jpeg.size()));
+  mBuffer.append(QLatin1Char('"'));
+  return finish();
+}
+
+const QString &FrameWriter::sessionEnd() {
+  static const QString frame = QLatin1String("{\"code\":80}");
+  return frame;
+}
+
+const QString &FrameWriter::keepalive() {
+  static const QString frame = QLatin1String("{\"code\":1003}");
+  return frame;
+}
+
+} // namespace Czateria
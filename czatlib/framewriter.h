@@ -0,0 +1,50 @@
+#ifndef FRAMEWRITER_H
+#define FRAMEWRITER_H
+
+#include <QString>
+
+class QByteArray;
+
+namespace Czateria {
+
+/* serialises the messages sent to the server. every message is a fixed
+ * template with only a handful of variable fields, so instead of building a
+ * QJsonObject and having QJsonDocument serialise it, the constant parts are
+ * copied verbatim and only the variable fields are escaped.
+ * every frame is handed over to the caller, as the connection holds on to it
+ * until it's sent. each one takes a single allocation, sized after the
+ * previous frame. */
+class FrameWriter {
+public:
+  // code 108
+  QString login(const QString &sessionId, const QString &channelName,
+                const QString &nickname);
+  // code 1
+  QString roomMessage(const QString &message);
+  // code 97, subcodes 1, 2, 13, 14 and 25 respectively
+  QString privInvite(const QString &message, const QString &nickname);
+  QString privMessage(const QString &message, const QString &nickname);
+  QString privReject(const QString &nickname);
+  QString privClosed(const QString &nickname);
+  QString privImage(const QString &nickname, int width, int height,
+                    const QByteArray &base64Jpeg);
+
+  // codes 80 and 1003 have no variable fields at all.
+  static const QString &sessionEnd();
+  static const QString &keepalive();
+
+private:
+  void begin(QLatin1String prefix);
+  void append(QLatin1String fragment) { mBuffer.append(fragment); }
+  void appendString(const QString &str);
+  void appendInt(int value);
+  void appendMessageCommon(const QString &message);
+  QString finish();
+
+  QString mBuffer;
+  int mLastSize = 0;
+};
+
+} // namespace Czateria
+
+#endif // FRAMEWRITER_H
@@ -0,0 +1,114 @@
+#include "imageencoder.h"
+
+#include <QBuffer>
+#include <QImageWriter>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <utility>
+
+#include "imagepayloadcache.h"
+
+namespace {
+Czateria::JpegEncoder::Settings &defaultSettingsStorage() {
+  static Czateria::JpegEncoder::Settings settings;
+  return settings;
+}
+
+// one thread keeps the images in order, and keeps encoding them from taking
+// over the global pool.
+QThreadPool &encoderPool() {
+  static QThreadPool pool;
+  static const bool configured = []() {
+    pool.setMaxThreadCount(1);
+    return true;
+  }();
+  Q_UNUSED(configured);
+  return pool;
+}
+
+// only ever used on the pool's one thread, so that its buffers are allocated
+// once rather than for every image.
+Czateria::JpegEncoder &poolEncoder() {
+  static Czateria::JpegEncoder encoder;
+  return encoder;
+}
+
+// the qualities tried are multiples of this, which makes for fewer attempts
+// without any noticeable difference.
+constexpr int qualityStep = 5;
+} // namespace
+
+namespace Czateria {
+
+void JpegEncoder::setDefaultSettings(const Settings &settings) {
+  defaultSettingsStorage() = settings;
+}
+
+const JpegEncoder::Settings &JpegEncoder::defaultSettings() {
+  return defaultSettingsStorage();
+}
+
+QByteArray JpegEncoder::encode(const QImage &image) {
+  mScratch.reserve(mSettings.budget * 2);
+  mBest.reserve(mSettings.budget * 2);
+  if (encode(image, mSettings.maxQuality, mBest) &&
+      mBest.size() <= mSettings.budget) {
+    return mBest;
+  }
+  // the highest quality which fits, found by bisection over the steps below
+  // the maximum.
+  int low = 0;
+  int high = (mSettings.maxQuality - mSettings.minQuality) / qualityStep - 1;
+  bool found = false;
+  while (low <= high) {
+    const auto step = (low + high) / 2;
+    const auto quality = mSettings.minQuality + step * qualityStep;
+    if (!encode(image, quality, mScratch)) {
+      return QByteArray();
+    }
+    if (mScratch.size() <= mSettings.budget) {
+      std::swap(mScratch, mBest);
+      found = true;
+      low = step + 1;
+    } else {
+      high = step - 1;
+    }
+  }
+  if (!found && !encode(image, mSettings.minQuality, mBest)) {
+    return QByteArray();
+  }
+  return mBest;
+}
+
+bool JpegEncoder::encode(const QImage &image, int quality, QByteArray &out) {
+  // keeps the memory reserved, unlike clear().
+  out.resize(0);
+  QBuffer buf(&out);
+  buf.open(QIODevice::WriteOnly);
+  QImageWriter writer(&buf, "JPG");
+  writer.setQuality(quality);
+  // smaller Huffman tables, at a negligible cost.
+  writer.setOptimizedWrite(true);
+  return writer.write(image);
+}
+
+ImageEncodeJob::ImageEncodeJob(const QImage &image, const QSize &maxSize)
+    : mImage(image), mMaxSize(maxSize),
+      mSettings(JpegEncoder::defaultSettings()) {
+  // deleted on the thread it was created on instead.
+  setAutoDelete(false);
+}
+
+void ImageEncodeJob::start() { encoderPool().start(this); }
+
+void ImageEncodeJob::run() {
+  auto &encoder = poolEncoder();
+  encoder.setSettings(mSettings);
+  const auto payload =
+      ImagePayloadCache::instance().encode(mImage, mMaxSize, encoder);
+  emit finished(payload.width, payload.height, payload.base64Jpeg);
+  deleteLater();
+}
+
+} // namespace Czateria
@@ -0,0 +1,72 @@
+#ifndef IMAGEENCODER_H
+#define IMAGEENCODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QRunnable>
+#include <QSize>
+
+namespace Czateria {
+
+/* encodes images as JPEG at the best quality that still fits within a byte
+ * budget, rather than at one fixed quality. pictures with little detail,
+ * like most screenshots, fit at the highest quality right away, while
+ * photos are brought down to a reasonable size.
+ * the encoder keeps its buffers between attempts and images, so it's meant
+ * to be used for one image after another rather than shared between
+ * threads. */
+class JpegEncoder {
+public:
+  struct Settings {
+    // of the JPEG data, before encoding it as base64.
+    int budget = 64 * 1024;
+    int minQuality = 40;
+    int maxQuality = 90;
+  };
+  // used for all encoders created afterwards.
+  static void setDefaultSettings(const Settings &settings);
+  static const Settings &defaultSettings();
+
+  JpegEncoder() : mSettings(defaultSettings()) {}
+
+  const Settings &settings() const { return mSettings; }
+  void setSettings(const Settings &settings) { mSettings = settings; }
+
+  // whatever fits best, or the lowest quality if nothing does.
+  QByteArray encode(const QImage &image);
+
+private:
+  bool encode(const QImage &image, int quality, QByteArray &out);
+
+  Settings mSettings;
+  QByteArray mScratch;
+  QByteArray mBest;
+};
+
+/* scales and encodes an image for sending on a worker thread, by means of the
+ * ImagePayloadCache. the images are encoded one at a time, in the order the
+ * jobs are started, so that they go out in the order they were sent, and all
+ * by the same encoder. the encoder settings are the defaults as of creating
+ * the job. the job deletes itself once it's done. */
+class ImageEncodeJob : public QObject, public QRunnable {
+  Q_OBJECT
+public:
+  ImageEncodeJob(const QImage &image, const QSize &maxSize);
+  // to be called after connecting to finished().
+  void start();
+
+signals:
+  void finished(int width, int height, const QByteArray &base64Jpeg);
+
+private:
+  void run() override;
+
+  const QImage mImage;
+  const QSize mMaxSize;
+  const JpegEncoder::Settings mSettings;
+};
+
+} // namespace Czateria
+
+#endif // IMAGEENCODER_H
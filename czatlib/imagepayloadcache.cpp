@@ -0,0 +1,82 @@
+#include "imagepayloadcache.h"
+
+#include <QCryptographicHash>
+#include <QImage>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <iterator>
+
+#include "imageencoder.h"
+
+namespace {
+QByteArray contentHash(const QImage &image) {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  const int header[] = {image.width(), image.height(),
+                        static_cast<int>(image.format())};
+  hash.addData(reinterpret_cast<const char *>(header),
+               static_cast<int>(sizeof(header)));
+  // scanlines may be padded, and the padding can be anything.
+  const auto lineBytes = (image.width() * image.depth() + 7) / 8;
+  for (int y = 0; y < image.height(); ++y) {
+    hash.addData(reinterpret_cast<const char *>(image.constScanLine(y)),
+                 lineBytes);
+  }
+  return hash.result();
+}
+
+} // namespace
+
+namespace Czateria {
+
+constexpr int ImagePayloadCache::maxBytes;
+
+ImagePayloadCache &ImagePayloadCache::instance() {
+  static ImagePayloadCache cache;
+  return cache;
+}
+
+ImagePayloadCache::Payload ImagePayloadCache::encode(const QImage &image,
+                                                     const QSize &maxSize,
+                                                     JpegEncoder &encoder) {
+  const auto hash = contentHash(image);
+  const auto budget = encoder.settings().budget;
+  {
+    QMutexLocker lock(&mMutex);
+    auto it = std::find_if(std::begin(mEntries), std::end(mEntries),
+                           [&](auto &&entry) {
+                             return entry.hash == hash &&
+                                    entry.maxSize == maxSize &&
+                                    entry.budget == budget;
+                           });
+    if (it != std::end(mEntries)) {
+      std::rotate(it, std::next(it), std::end(mEntries));
+      return mEntries.back().payload;
+    }
+  }
+  // encoding takes a while, and other images shouldn't have to wait for it.
+  const auto scaled =
+      image.width() > maxSize.width() || image.height() > maxSize.height()
+          ? image.scaled(maxSize, Qt::KeepAspectRatio,
+                         Qt::SmoothTransformation)
+          : image;
+  Payload payload{scaled.width(), scaled.height(),
+                  encoder.encode(scaled).toBase64()};
+
+  QMutexLocker lock(&mMutex);
+  const auto size = payload.base64Jpeg.size();
+  if (size == 0 || size > maxBytes) {
+    return payload;
+  }
+  mEntries.push_back({hash, maxSize, budget, payload});
+  mTotalBytes += size;
+  auto evicted = std::begin(mEntries);
+  while (mTotalBytes > maxBytes) {
+    mTotalBytes -= evicted->payload.base64Jpeg.size();
+    ++evicted;
+  }
+  mEntries.erase(std::begin(mEntries), evicted);
+  return payload;
+}
+
+} // namespace Czateria
@@ -0,0 +1,57 @@
+#ifndef IMAGEPAYLOADCACHE_H
+#define IMAGEPAYLOADCACHE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QSize>
+
+#include <vector>
+
+class QImage;
+
+namespace Czateria {
+class JpegEncoder;
+
+/* images scaled and encoded the way they're sent, so that sending the same
+ * picture to several people, in whichever room, only goes through that once.
+ * images are told apart by their contents rather than by the QImage they
+ * came in, as dropping or pasting a picture again makes a new one. the most
+ * recently used payloads are kept, up to a total size.
+ * safe to use from any thread. */
+class ImagePayloadCache {
+public:
+  static ImagePayloadCache &instance();
+
+  struct Payload {
+    int width;
+    int height;
+    QByteArray base64Jpeg;
+  };
+
+  // the image is scaled down to fit within maxSize, keeping its aspect ratio.
+  // the encoder is only used if the image isn't in the cache yet.
+  Payload encode(const QImage &image, const QSize &maxSize,
+                 JpegEncoder &encoder);
+
+  static constexpr int maxBytes = 8 * 1024 * 1024;
+
+private:
+  ImagePayloadCache() = default;
+
+  struct Entry {
+    QByteArray hash;
+    QSize maxSize;
+    // of the encoder, which may have been changed since.
+    int budget;
+    Payload payload;
+  };
+
+  QMutex mMutex;
+  // the most recently used ones last.
+  std::vector<Entry> mEntries;
+  int mTotalBytes = 0;
+};
+
+} // namespace Czateria
+
+#endif // IMAGEPAYLOADCACHE_H
@@ -0,0 +1,86 @@
+#include "joinscheduler.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+
+namespace Czateria {
+
+JoinScheduler &JoinScheduler::instance() {
+  static JoinScheduler scheduler;
+  return scheduler;
+}
+
+JoinScheduler::JoinScheduler() {
+  mClock.start();
+  mTimer.setSingleShot(true);
+  connect(&mTimer, &QTimer::timeout, this, &JoinScheduler::pump);
+}
+
+int JoinScheduler::add(StartFn start, Priority priority) {
+  const auto id = mNextId++;
+  mWaiting.push_back({id, std::move(start), priority});
+  pump();
+  return id;
+}
+
+void JoinScheduler::setPriority(int id, Priority priority) {
+  auto it = std::find_if(std::begin(mWaiting), std::end(mWaiting),
+                         [=](auto &&waiting) { return waiting.id == id; });
+  if (it != std::end(mWaiting)) {
+    it->priority = priority;
+  }
+}
+
+void JoinScheduler::finished(int id) {
+  if (mRunning.remove(id)) {
+    pump();
+    return;
+  }
+  mWaiting.erase(
+      std::remove_if(std::begin(mWaiting), std::end(mWaiting),
+                     [=](auto &&waiting) { return waiting.id == id; }),
+      std::end(mWaiting));
+}
+
+void JoinScheduler::pump() {
+  const auto now = mClock.elapsed();
+  for (auto it = std::begin(mRunning); it != std::end(mRunning);) {
+    if (now - it.value() >= mLimits.timeout) {
+      qInfo() << "Join" << it.key() << "timed out, starting the next one";
+      it = mRunning.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (mWaiting.empty()) {
+    mTimer.stop();
+    return;
+  }
+  if (mRunning.size() >= std::max(mLimits.maxConcurrent, 1)) {
+    // one of them finishing sooner pumps again anyway.
+    const auto oldest = *std::min_element(std::begin(mRunning),
+                                          std::end(mRunning));
+    mTimer.start(static_cast<int>(oldest + mLimits.timeout - now));
+    return;
+  }
+  if (mLastStart >= 0 && now - mLastStart < mLimits.spacing) {
+    mTimer.start(static_cast<int>(mLastStart + mLimits.spacing - now));
+    return;
+  }
+  // the first one with the highest priority.
+  auto it = std::max_element(
+      std::begin(mWaiting), std::end(mWaiting),
+      [](auto &&a, auto &&b) { return a.priority < b.priority; });
+  const auto id = it->id;
+  const auto start = std::move(it->start);
+  mWaiting.erase(it);
+  mRunning.insert(id, now);
+  mLastStart = now;
+  start();
+  // schedules whatever comes next.
+  pump();
+}
+
+} // namespace Czateria
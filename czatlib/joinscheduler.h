@@ -0,0 +1,72 @@
+#ifndef JOINSCHEDULER_H
+#define JOINSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+#include <vector>
+
+namespace Czateria {
+
+/* paces joining rooms, so that a bunch of them being joined at once, like
+ * when logging in automatically, doesn't mean as many handshakes and user
+ * lists to go through all at the same time.
+ * only so many joins are in progress at a time, with some time in between
+ * starting them. a join is over once its room's user list is in, or after a
+ * timeout, whichever comes first. the joins which are waiting are started
+ * in the order of their priority, and then in the order they were added. */
+class JoinScheduler : public QObject {
+  Q_OBJECT
+public:
+  static JoinScheduler &instance();
+
+  struct Limits {
+    int maxConcurrent = 2;
+    // between starting two joins.
+    int spacing = 500;
+    // a join taking longer than this no longer holds the others back.
+    int timeout = 15000;
+  };
+  void setLimits(const Limits &limits) { mLimits = limits; }
+  const Limits &limits() const { return mLimits; }
+
+  // the higher, the sooner.
+  enum Priority { Hidden, Visible, Focused };
+
+  using StartFn = std::function<void()>;
+  // starts the join right away if nothing is holding it back. returns an id
+  // to be used with the rest of the functions.
+  int add(StartFn start, Priority priority);
+  // no effect once the join is started.
+  void setPriority(int id, Priority priority);
+  void finished(int id);
+  // cancels the join if it's not started yet.
+  void remove(int id) { finished(id); }
+
+private:
+  JoinScheduler();
+
+  struct Waiting {
+    int id;
+    StartFn start;
+    Priority priority;
+  };
+
+  void pump();
+
+  Limits mLimits;
+  std::vector<Waiting> mWaiting;
+  // joins in progress, along with when they were started.
+  QHash<int, qint64> mRunning;
+  qint64 mLastStart = -1;
+  int mNextId = 1;
+  QElapsedTimer mClock;
+  QTimer mTimer;
+};
+
+} // namespace Czateria
+
+#endif // JOINSCHEDULER_H
@@ -0,0 +1,428 @@
+#include "jsonreader.h"
+
+#include <array>
+#include <cstring>
+
+namespace {
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+bool readHex4(const char *p, const char *end, unsigned &out) {
+  if (end - p < 4) {
+    return false;
+  }
+  out = 0;
+  for (int i = 0; i < 4; ++i) {
+    auto v = hexValue(p[i]);
+    if (v < 0) {
+      return false;
+    }
+    out = (out << 4) | static_cast<unsigned>(v);
+  }
+  return true;
+}
+
+void appendUtf8(QByteArray &out, unsigned cp) {
+  if (cp < 0x80) {
+    out.append(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.append(static_cast<char>(0xC0 | (cp >> 6)));
+    out.append(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out.append(static_cast<char>(0xE0 | (cp >> 12)));
+    out.append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.append(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out.append(static_cast<char>(0xF0 | (cp >> 18)));
+    out.append(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out.append(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.append(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+
+bool isValueTerminator(char c) {
+  switch (c) {
+  case ',':
+  case '}':
+  case ']':
+  case ' ':
+  case '\t':
+  case '\r':
+  case '\n':
+    return true;
+  }
+  return false;
+}
+
+// -1 for whatever isn't part of the alphabet.
+const std::array<signed char, 256> &base64Values() {
+  static const auto values = []() {
+    std::array<signed char, 256> rv;
+    rv.fill(-1);
+    const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (int i = 0; i < 64; ++i) {
+      rv[static_cast<unsigned char>(alphabet[i])] = static_cast<signed char>(i);
+    }
+    return rv;
+  }();
+  return values;
+}
+} // namespace
+
+namespace Czateria {
+
+bool JsonReader::skipWhitespace() {
+  while (mPos != mEnd) {
+    switch (*mPos) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      ++mPos;
+      break;
+    default:
+      return true;
+    }
+  }
+  return false;
+}
+
+bool JsonReader::expect(char c) {
+  if (!mError && skipWhitespace() && *mPos == c) {
+    ++mPos;
+    return true;
+  }
+  mError = true;
+  return false;
+}
+
+bool JsonReader::atObject() {
+  return !mError && skipWhitespace() && *mPos == '{';
+}
+
+bool JsonReader::atArray() {
+  return !mError && skipWhitespace() && *mPos == '[';
+}
+
+bool JsonReader::beginObject() { return expect('{'); }
+
+bool JsonReader::beginArray() { return expect('['); }
+
+bool JsonReader::nextMember(QLatin1String &key) {
+  if (mError || !skipWhitespace()) {
+    mError = true;
+    return false;
+  }
+  if (*mPos == ',') {
+    ++mPos;
+    if (!skipWhitespace()) {
+      mError = true;
+      return false;
+    }
+  }
+  if (*mPos == '}') {
+    ++mPos;
+    return false;
+  }
+  const char *begin, *end;
+  bool hasEscapes;
+  if (!scanString(begin, end, hasEscapes) || !expect(':')) {
+    mError = true;
+    return false;
+  }
+  // keys used by the protocol are plain ASCII, so there's no need to bother
+  // with unescaping them.
+  key = QLatin1String(begin, static_cast<int>(end - begin));
+  return true;
+}
+
+bool JsonReader::nextElement() {
+  if (mError || !skipWhitespace()) {
+    mError = true;
+    return false;
+  }
+  if (*mPos == ',') {
+    ++mPos;
+    if (!skipWhitespace()) {
+      mError = true;
+      return false;
+    }
+  }
+  if (*mPos == ']') {
+    ++mPos;
+    return false;
+  }
+  return true;
+}
+
+bool JsonReader::scanString(const char *&begin, const char *&end,
+                            bool &hasEscapes) {
+  if (mError || !skipWhitespace() || *mPos != '"') {
+    return false;
+  }
+  hasEscapes = false;
+  begin = ++mPos;
+  while (mPos != mEnd) {
+    const auto c = *mPos;
+    if (c == '"') {
+      end = mPos++;
+      return true;
+    } else if (c == '\\') {
+      hasEscapes = true;
+      if (mEnd - mPos < 2) {
+        break;
+      }
+      mPos += 2;
+    } else {
+      ++mPos;
+    }
+  }
+  mError = true;
+  return false;
+}
+
+void JsonReader::unescape(const char *begin, const char *end,
+                          QByteArray &out) {
+  out.clear();
+  out.reserve(static_cast<int>(end - begin));
+  auto p = begin;
+  while (p != end) {
+    auto bs = static_cast<const char *>(
+        std::memchr(p, '\\', static_cast<std::size_t>(end - p)));
+    if (!bs) {
+      out.append(p, static_cast<int>(end - p));
+      break;
+    }
+    out.append(p, static_cast<int>(bs - p));
+    p = bs + 1; // scanString guarantees there's a character after a backslash
+    switch (*p) {
+    case 'b':
+      out.append('\b');
+      break;
+    case 'f':
+      out.append('\f');
+      break;
+    case 'n':
+      out.append('\n');
+      break;
+    case 'r':
+      out.append('\r');
+      break;
+    case 't':
+      out.append('\t');
+      break;
+    case 'u': {
+      unsigned cp;
+      if (!readHex4(p + 1, end, cp)) {
+        mError = true;
+        return;
+      }
+      p += 4;
+      if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 7 && p[1] == '\\' &&
+          p[2] == 'u') {
+        unsigned low;
+        if (readHex4(p + 3, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          p += 6;
+        }
+      }
+      appendUtf8(out, cp);
+      break;
+    }
+    default: // '"', '\\', '/' and anything unknown are taken literally.
+      out.append(*p);
+      break;
+    }
+    ++p;
+  }
+}
+
+void JsonReader::read(QByteArray &out) {
+  const char *begin, *end;
+  bool hasEscapes;
+  if (mError || !skipWhitespace() || *mPos != '"') {
+    skipValue();
+    out = QByteArray();
+  } else if (scanString(begin, end, hasEscapes)) {
+    if (hasEscapes) {
+      unescape(begin, end, out);
+    } else {
+      out = QByteArray(begin, static_cast<int>(end - begin));
+    }
+  }
+}
+
+void JsonReader::readBase64(QByteArray &out) {
+  const char *begin, *end;
+  bool hasEscapes;
+  out = QByteArray();
+  if (mError || !skipWhitespace() || *mPos != '"') {
+    skipValue();
+    return;
+  }
+  if (!scanString(begin, end, hasEscapes)) {
+    return;
+  }
+  auto &&values = base64Values();
+  // enough for the whole string, escapes and all.
+  out.resize(static_cast<int>((end - begin) / 4 * 3 + 3));
+  auto dst = out.data();
+  unsigned bits = 0;
+  int bitCount = 0;
+  for (auto p = begin; p != end; ++p) {
+    auto c = *p;
+    if (c == '\\') {
+      ++p; // scanString guarantees there's a character after a backslash
+      if (*p == 'u') {
+        unsigned cp;
+        if (!readHex4(p + 1, end, cp)) {
+          mError = true;
+          out = QByteArray();
+          return;
+        }
+        p += 4;
+        c = cp < 0x80 ? static_cast<char>(cp) : ' ';
+      } else if (*p == '/') {
+        c = '/';
+      } else {
+        // line breaks and such.
+        continue;
+      }
+    }
+    if (c == '=') {
+      break;
+    }
+    // like QByteArray::fromBase64, anything outside the alphabet is skipped.
+    const auto value = values[static_cast<unsigned char>(c)];
+    if (value < 0) {
+      continue;
+    }
+    bits = (bits << 6) | static_cast<unsigned>(value);
+    bitCount += 6;
+    if (bitCount >= 8) {
+      bitCount -= 8;
+      *dst++ = static_cast<char>(bits >> bitCount);
+      bits &= (1u << bitCount) - 1;
+    }
+  }
+  out.resize(static_cast<int>(dst - out.constData()));
+}
+
+void JsonReader::read(QString &out) {
+  const char *begin, *end;
+  bool hasEscapes;
+  if (mError || !skipWhitespace() || *mPos != '"') {
+    skipValue();
+    out = QString();
+  } else if (scanString(begin, end, hasEscapes)) {
+    if (hasEscapes) {
+      QByteArray unescaped;
+      unescape(begin, end, unescaped);
+      out = QString::fromUtf8(unescaped);
+    } else {
+      out = QString::fromUtf8(begin, static_cast<int>(end - begin));
+    }
+  }
+}
+
+void JsonReader::read(int &out) {
+  out = 0;
+  if (mError || !skipWhitespace()) {
+    mError = true;
+    return;
+  }
+  auto p = mPos;
+  const bool negative = *p == '-';
+  if (negative) {
+    ++p;
+  }
+  if (p == mEnd || *p < '0' || *p > '9') {
+    skipValue();
+    return;
+  }
+  long long value = 0;
+  while (p != mEnd && *p >= '0' && *p <= '9') {
+    if (value < (1ll << 32)) {
+      value = value * 10 + (*p - '0');
+    }
+    ++p;
+  }
+  mPos = p;
+  // fractions and exponents aren't used by the protocol for integer values.
+  // whatever follows is simply dropped.
+  while (mPos != mEnd && !isValueTerminator(*mPos)) {
+    ++mPos;
+  }
+  out = static_cast<int>(negative ? -value : value);
+}
+
+void JsonReader::read(bool &out) {
+  out = false;
+  if (mError || !skipWhitespace()) {
+    mError = true;
+    return;
+  }
+  if (mEnd - mPos >= 4 && std::memcmp(mPos, "true", 4) == 0) {
+    out = true;
+    mPos += 4;
+  } else {
+    skipValue();
+  }
+}
+
+void JsonReader::skipValue() {
+  if (mError || !skipWhitespace()) {
+    mError = true;
+    return;
+  }
+  const char *begin, *end;
+  bool hasEscapes;
+  switch (*mPos) {
+  case '"':
+    scanString(begin, end, hasEscapes);
+    return;
+  case '{':
+  case '[': {
+    int depth = 0;
+    while (mPos != mEnd) {
+      switch (*mPos) {
+      case '"':
+        if (!scanString(begin, end, hasEscapes)) {
+          return;
+        }
+        continue;
+      case '{':
+      case '[':
+        ++depth;
+        break;
+      case '}':
+      case ']':
+        if (--depth == 0) {
+          ++mPos;
+          return;
+        }
+        break;
+      }
+      ++mPos;
+    }
+    mError = true;
+    return;
+  }
+  default:
+    while (mPos != mEnd && !isValueTerminator(*mPos)) {
+      ++mPos;
+    }
+    return;
+  }
+}
+
+} // namespace Czateria
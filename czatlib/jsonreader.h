@@ -0,0 +1,116 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace Czateria {
+
+/* a minimal pull parser working directly on the UTF-8 representation of a JSON
+ * document. unlike QJsonDocument, it doesn't build any intermediate DOM : the
+ * caller walks the document and either reads the values it's interested in
+ * or skips them. it's lenient by design and only guarantees not to read past
+ * the end of the buffer, which is all we need for the server's messages.
+ * conversions follow the rules of QJsonValue, i.e. reading a value of an
+ * unexpected type yields a default-constructed result. */
+class JsonReader {
+public:
+  explicit JsonReader(const QByteArray &data)
+      : mPos(data.constData()), mEnd(data.constData() + data.size()) {}
+  JsonReader(const char *begin, const char *end) : mPos(begin), mEnd(end) {}
+
+  bool beginObject();
+  // reads the next member's key along with the separating colon. returns false
+  // after consuming the closing brace, or on error.
+  bool nextMember(QLatin1String &key);
+  bool beginArray();
+  // returns false after consuming the closing bracket, or on error.
+  bool nextElement();
+
+  void read(QString &out);
+  // reads a string with escape sequences resolved, but without converting it
+  // from UTF-8.
+  void read(QByteArray &out);
+  // decodes a base64 string straight from the document, without making an
+  // unescaped copy of it first. yields a null array if the value isn't a
+  // string.
+  void readBase64(QByteArray &out);
+  void read(int &out);
+  void read(bool &out);
+  void skipValue();
+
+  bool atObject();
+  bool atArray();
+  bool hasError() const { return mError; }
+  const char *position() const { return mPos; }
+
+private:
+  bool skipWhitespace();
+  bool expect(char c);
+  // on success, [begin, end) is the raw, still escaped string content.
+  bool scanString(const char *&begin, const char *&end, bool &hasEscapes);
+  void unescape(const char *begin, const char *end, QByteArray &out);
+
+  const char *mPos;
+  const char *const mEnd;
+  bool mError = false;
+};
+
+/* maps a JSON object's member name to a function storing its value in a field
+ * of T. tables of these are used to deserialise objects straight into
+ * structs. */
+template <typename T> struct JsonField {
+  QLatin1String name;
+  void (*read)(JsonReader &, T &);
+};
+
+template <typename T, std::size_t N>
+using JsonFieldTable = std::array<JsonField<T>, N>;
+
+template <typename T, std::size_t N>
+bool readObject(JsonReader &reader, T &out,
+                const JsonFieldTable<T, N> &fields) {
+  if (!reader.atObject()) {
+    reader.skipValue();
+    return !reader.hasError();
+  }
+  reader.beginObject();
+  QLatin1String key(nullptr);
+  while (reader.nextMember(key)) {
+    const auto end = std::end(fields);
+    auto it = std::find_if(std::begin(fields), end,
+                           [&](auto &&field) { return field.name == key; });
+    if (it != end) {
+      it->read(reader, out);
+    } else {
+      reader.skipValue();
+    }
+  }
+  return !reader.hasError();
+}
+
+template <typename T, std::size_t N>
+bool readArray(JsonReader &reader, std::vector<T> &out,
+               const JsonFieldTable<T, N> &fields) {
+  if (!reader.atArray()) {
+    reader.skipValue();
+    return !reader.hasError();
+  }
+  reader.beginArray();
+  while (reader.nextElement()) {
+    T item;
+    if (!readObject(reader, item, fields)) {
+      break;
+    }
+    out.push_back(std::move(item));
+  }
+  return !reader.hasError();
+}
+
+} // namespace Czateria
+
+#endif // JSONREADER_H
@@ -0,0 +1,111 @@
+#include "keepalivescheduler.h"
+
+#include <algorithm>
+
+namespace Czateria {
+
+constexpr qint64 KeepaliveScheduler::defaultInterval;
+constexpr qint64 KeepaliveScheduler::maxInterval;
+constexpr int KeepaliveScheduler::tickInterval;
+constexpr int KeepaliveScheduler::wheelSize;
+
+KeepaliveScheduler &KeepaliveScheduler::instance() {
+  static KeepaliveScheduler scheduler;
+  return scheduler;
+}
+
+KeepaliveScheduler::KeepaliveScheduler() {
+  mClock.start();
+  // keepalives don't need to be on time to the millisecond, so let the system
+  // batch these wakeups with others.
+  mTimer.setTimerType(Qt::VeryCoarseTimer);
+  mTimer.setInterval(tickInterval);
+  connect(&mTimer, &QTimer::timeout, this, &KeepaliveScheduler::tick);
+}
+
+int KeepaliveScheduler::add(SendFn send) {
+  const auto id = mNextId++;
+  auto &entry = mEntries[id];
+  entry.send = std::move(send);
+  entry.lastTraffic = mClock.elapsed();
+  schedule(id, entry);
+  if (!mTimer.isActive()) {
+    mTimer.start();
+  }
+  return id;
+}
+
+void KeepaliveScheduler::remove(int id) {
+  // the id is left in its slot, and skipped once it comes up.
+  mEntries.remove(id);
+  if (mEntries.isEmpty()) {
+    mTimer.stop();
+    for (auto &&slot : mWheel) {
+      slot.clear();
+    }
+  }
+}
+
+void KeepaliveScheduler::noteTraffic(int id) {
+  // this happens for every frame, so all it does is store the time. the entry
+  // gets moved to the right slot only once its current one comes up.
+  auto it = mEntries.find(id);
+  if (it != std::end(mEntries)) {
+    it->lastTraffic = mClock.elapsed();
+  }
+}
+
+void KeepaliveScheduler::noteServerRequest(int id) {
+  auto it = mEntries.find(id);
+  if (it == std::end(mEntries)) {
+    return;
+  }
+  const auto now = mClock.elapsed();
+  if (it->lastServerRequest >= 0) {
+    // staying well within the server's own cadence leaves room for a request
+    // or two getting lost or delayed.
+    it->interval = std::max(
+        defaultInterval,
+        std::min(maxInterval, (now - it->lastServerRequest) / 2));
+  }
+  it->lastServerRequest = now;
+}
+
+void KeepaliveScheduler::schedule(int id, Entry &entry) {
+  entry.deadline = entry.lastTraffic + entry.interval;
+  const auto ticks =
+      (entry.deadline - mClock.elapsed() + tickInterval - 1) / tickInterval;
+  const auto offset = static_cast<int>(
+      std::max<qint64>(1, std::min<qint64>(ticks, wheelSize - 1)));
+  entry.slot = (mCurrentSlot + offset) % wheelSize;
+  mWheel[static_cast<std::size_t>(entry.slot)].push_back(id);
+}
+
+void KeepaliveScheduler::tick() {
+  mCurrentSlot = (mCurrentSlot + 1) % wheelSize;
+  auto due = std::move(mWheel[static_cast<std::size_t>(mCurrentSlot)]);
+  mWheel[static_cast<std::size_t>(mCurrentSlot)].clear();
+  const auto now = mClock.elapsed();
+  for (auto id : due) {
+    auto it = mEntries.find(id);
+    if (it == std::end(mEntries) || it->slot != mCurrentSlot) {
+      continue;
+    }
+    // the tick may come slightly early, which is as good as on time.
+    if (it->lastTraffic + it->interval <= now + tickInterval / 2) {
+      // for connections on worker threads, noteTraffic() only comes once the
+      // frame has been written, well after this. the entry is marked here
+      // instead, so that it's rescheduled a full interval from now either way.
+      it->send();
+      // the send function is free to remove the entry.
+      it = mEntries.find(id);
+      if (it == std::end(mEntries)) {
+        continue;
+      }
+      it->lastTraffic = std::max(it->lastTraffic, now);
+    }
+    schedule(id, *it);
+  }
+}
+
+} // namespace Czateria
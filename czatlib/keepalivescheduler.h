@@ -0,0 +1,67 @@
+#ifndef KEEPALIVESCHEDULER_H
+#define KEEPALIVESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace Czateria {
+
+/* sends keepalives on behalf of all the sessions in the process off a single,
+ * coarse timer. sessions are kept in a timer wheel with one slot per tick, so
+ * a tick only ever looks at the sessions which are actually due.
+ * a keepalive is only sent if nothing else went out within the session's
+ * interval, and the interval itself follows the rate at which the server asks
+ * for keepalives (code 1003), within reasonable bounds. */
+class KeepaliveScheduler : public QObject {
+  Q_OBJECT
+public:
+  static KeepaliveScheduler &instance();
+
+  using SendFn = std::function<void()>;
+  // returns an id to be used with the rest of the functions.
+  int add(SendFn send);
+  void remove(int id);
+  // to be called for every frame sent, including the keepalives themselves.
+  void noteTraffic(int id);
+  // to be called whenever the server asks for a keepalive.
+  void noteServerRequest(int id);
+
+  static constexpr qint64 defaultInterval = 40000;
+  static constexpr qint64 maxInterval = 120000;
+
+private:
+  KeepaliveScheduler();
+
+  static constexpr int tickInterval = 5000;
+  // enough to cover maxInterval, with some headroom.
+  static constexpr int wheelSize = 32;
+
+  struct Entry {
+    SendFn send;
+    qint64 lastTraffic;
+    qint64 lastServerRequest = -1;
+    qint64 interval = defaultInterval;
+    qint64 deadline;
+    int slot;
+  };
+
+  void schedule(int id, Entry &entry);
+  void tick();
+
+  QHash<int, Entry> mEntries;
+  std::array<std::vector<int>, wheelSize> mWheel;
+  int mCurrentSlot = 0;
+  int mNextId = 1;
+  QElapsedTimer mClock;
+  QTimer mTimer;
+};
+
+} // namespace Czateria
+
+#endif // KEEPALIVESCHEDULER_H
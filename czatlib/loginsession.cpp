@@ -12,6 +12,7 @@
 #include <QUrlQuery>
 
 #include "captcha.h"
+#include "endpoints.h"
 #include "room.h"
 #include "util.h"
 
@@ -60,13 +61,11 @@ void LoginSession::login(const Room &room, const QString &nickname,
   mPassword = password;
   auto postData = getBasicPostData(room);
   postData.addQueryItem(QLatin1String("password"), password);
-  sendPostData(
-      QUrl(QLatin1String("https://czateria-api.interia.pl/scp/user/login")),
-      postData);
+  sendPostData(Endpoints::userLogin(), postData);
 }
 
 bool LoginSession::restart(const Room &room) {
-  if (mPassword.isEmpty()) {
+  if (!canRestart()) {
     // only registered users can restart seamlessly due to no captcha being
     // needed
     return false;
@@ -86,9 +85,7 @@ void LoginSession::setCaptchaReply(const Room &room, const QString &reply) {
   if (mNickname.isEmpty()) {
     postData.addQueryItem(QLatin1String("randomNick"), QLatin1String("1"));
   }
-  sendPostData(
-      QUrl(QLatin1String("https://czateria-api.interia.pl/scp/user/guest")),
-      postData);
+  sendPostData(Endpoints::guestLogin(), postData);
 }
 
 void LoginSession::onReplyReceived(const QByteArray &data) {
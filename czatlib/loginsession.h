@@ -22,6 +22,8 @@ public:
   void login(const Room &room, const QString &nickname,
              const QString &password);
   bool restart(const Room &room);
+  // only registered users can log back in without any user interaction.
+  bool canRestart() const { return !mPassword.isEmpty(); }
 
   void setCaptchaReply(const Room &room, const QString &reply);
 
@@ -41,7 +43,7 @@ private:
   QString mPassword;
   QString mSessionId;
   QString mCaptchaUid;
-  bool mLoginOngoing;
+  bool mLoginOngoing = false;
 
   void onReplyReceived(const QByteArray &content);
   void sendPostData(const QUrl &address, const QUrlQuery &postData);
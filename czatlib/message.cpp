@@ -1,30 +1,37 @@
 #include "message.h"
 #include "icons.h"
 
-#include <QJsonObject>
-
 namespace Czateria {
 
-Message Message::privMessage(const QJsonObject &json) {
-  return Message{json[QLatin1String("msg")].toString(),
-                 json[QLatin1String("user")].toString()};
-}
-
-Message Message::roomMessage(const QJsonObject &json) {
-  return Message{json[QLatin1String("msg")].toString(),
-                 json[QLatin1String("login")].toString()};
-}
-
 Message::Message(const QDateTime &msgTime, const QString &msg,
                  const QString &nickname)
     : mReceivedAt(msgTime), mRawMessage(msg), mNickname(nickname) {}
 
+Message Message::fromUtf8(const QDateTime &msgTime, const QByteArray &msg,
+                          const QString &nickname) {
+  Message rv;
+  rv.mReceivedAt = msgTime;
+  rv.mRawMessageUtf8 = msg;
+  rv.mNickname = nickname;
+  return rv;
+}
+
 QString Message::message(IconReplaceMode replaceMode) const {
-  return convertRawMessage(mRawMessage, replaceMode);
+  return convertRawMessage(rawMessage(), replaceMode);
 }
 
-Message::Message(const QString &msg, const QString &nick)
-    : mReceivedAt(QDateTime::currentDateTime()), mRawMessage(msg),
-      mNickname(nick) {}
+const QString &Message::rawMessage() const {
+  if (mRawMessage.isNull() && !mRawMessageUtf8.isNull()) {
+    mRawMessage = QString::fromUtf8(mRawMessageUtf8);
+  }
+  return mRawMessage;
+}
+
+const QByteArray &Message::rawMessageUtf8() const {
+  if (mRawMessageUtf8.isNull() && !mRawMessage.isNull()) {
+    mRawMessageUtf8 = mRawMessage.toUtf8();
+  }
+  return mRawMessageUtf8;
+}
 
 } // namespace Czateria
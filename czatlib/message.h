@@ -2,30 +2,36 @@
 #define MESSAGE_H
 
 #include "icons.h"
+#include <QByteArray>
 #include <QDateTime>
 #include <QString>
-class QJsonObject;
 
 namespace Czateria {
 
+/* messages received from the server are kept in the UTF-8 form they arrived
+ * in, which is also what the logs are written in. the UTF-16 QString is only
+ * created when something actually asks for it, e.g. in order to display the
+ * message. messages created locally work the other way around. */
 class Message {
 public:
-  static Message roomMessage(const QJsonObject &code129Object);
-  static Message privMessage(const QJsonObject &code97Object);
   Message(const QDateTime &msgTime, const QString &msg,
           const QString &nickname);
+  static Message fromUtf8(const QDateTime &msgTime, const QByteArray &msg,
+                          const QString &nickname);
   Message() {}
 
   const QDateTime &receivedAt() const { return mReceivedAt; }
   const QString &nickname() const { return mNickname; }
   QString message(IconReplaceMode) const;
-  const QString &rawMessage() const { return mRawMessage; }
+  const QString &rawMessage() const;
+  const QByteArray &rawMessageUtf8() const;
 
 private:
-  Message(const QString &msg, const QString &nick);
+  friend class FrameDecoder;
 
   QDateTime mReceivedAt;
-  QString mRawMessage;
+  mutable QString mRawMessage;
+  mutable QByteArray mRawMessageUtf8;
   QString mNickname;
 };
 
@@ -0,0 +1,125 @@
+#include "outboundqueue.h"
+
+#include <QWebSocket>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+Czateria::OutboundQueue::Limits &defaultLimitsStorage() {
+  static Czateria::OutboundQueue::Limits limits;
+  return limits;
+}
+
+qint64 queuedSize(const QString &frame) {
+  return static_cast<qint64>(frame.size()) * static_cast<qint64>(sizeof(QChar));
+}
+} // namespace
+
+namespace Czateria {
+
+OutboundQueue::OutboundQueue(QWebSocket *socket, QObject *parent)
+    : QObject(parent), mSocket(socket), mLimits(defaultLimits()),
+      mTokens(mLimits.burst) {
+  mRefillClock.start();
+  mRefillTimer.setSingleShot(true);
+  connect(&mRefillTimer, &QTimer::timeout, this, &OutboundQueue::pump);
+  connect(mSocket, &QWebSocket::bytesWritten, this,
+          &OutboundQueue::onBytesWritten);
+}
+
+bool OutboundQueue::send(const QString &frame, Priority priority) {
+  if (priority == Priority::Control) {
+    write(frame);
+    return true;
+  }
+  const auto queuesEmpty = mQueues[0].empty() && mQueues[1].empty();
+  if (queuesEmpty && !mHeld && mBytesInFlight < mLimits.maxBytesInFlight &&
+      takeToken()) {
+    write(frame);
+    return true;
+  }
+  const auto size = queuedSize(frame);
+  if (mQueuedBytes + size > mLimits.maxQueuedBytes) {
+    return false;
+  }
+  mQueues[priority == Priority::Text ? 0 : 1].push_back(frame);
+  mQueuedBytes += size;
+  pump();
+  return true;
+}
+
+void OutboundQueue::setHeld(bool held) {
+  mHeld = held;
+  pump();
+}
+
+void OutboundQueue::setLimits(const Limits &limits) {
+  mLimits = limits;
+  mTokens = std::min(mTokens, static_cast<double>(mLimits.burst));
+  pump();
+}
+
+void OutboundQueue::setDefaultLimits(const Limits &limits) {
+  defaultLimitsStorage() = limits;
+}
+
+const OutboundQueue::Limits &OutboundQueue::defaultLimits() {
+  return defaultLimitsStorage();
+}
+
+bool OutboundQueue::takeToken() {
+  if (mLimits.framesPerSecond <= 0) {
+    return true;
+  }
+  mTokens = std::min(static_cast<double>(mLimits.burst),
+                     mTokens + mRefillClock.restart() *
+                                   mLimits.framesPerSecond / 1000.0);
+  if (mTokens < 1) {
+    return false;
+  }
+  mTokens -= 1;
+  return true;
+}
+
+void OutboundQueue::pump() {
+  if (mHeld) {
+    return;
+  }
+  for (;;) {
+    auto it = std::find_if(std::begin(mQueues), std::end(mQueues),
+                           [](auto &&queue) { return !queue.empty(); });
+    if (it == std::end(mQueues)) {
+      return;
+    }
+    if (mBytesInFlight >= mLimits.maxBytesInFlight) {
+      // onBytesWritten() gets things going again.
+      return;
+    }
+    if (!takeToken()) {
+      if (!mRefillTimer.isActive()) {
+        mRefillTimer.start(static_cast<int>(
+            std::ceil((1 - mTokens) * 1000 / mLimits.framesPerSecond)));
+      }
+      return;
+    }
+    const auto frame = std::move(it->front());
+    it->pop_front();
+    mQueuedBytes -= queuedSize(frame);
+    write(frame);
+  }
+}
+
+void OutboundQueue::write(const QString &frame) {
+  emit aboutToSend(frame);
+  mBytesInFlight += mSocket->sendTextMessage(frame);
+}
+
+void OutboundQueue::onBytesWritten(qint64 bytes) {
+  // what QWebSocket reports here doesn't necessarily add up to what
+  // sendTextMessage() returned, so make sure this can't go negative.
+  mBytesInFlight = std::max(mBytesInFlight - bytes, qint64(0));
+  pump();
+}
+
+} // namespace Czateria
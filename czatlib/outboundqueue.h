@@ -0,0 +1,76 @@
+#ifndef OUTBOUNDQUEUE_H
+#define OUTBOUNDQUEUE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <array>
+#include <deque>
+
+class QWebSocket;
+
+namespace Czateria {
+
+/* schedules the frames a session sends. control frames (login, keepalives,
+ * session end) are written right away, while everything else goes through a
+ * token bucket so that bursts don't trip the server's flood protection.
+ * queued text always goes before queued images, and nothing is written while
+ * the socket is still busy with more than maxBytesInFlight, so a large image
+ * can only ever delay text by the time it takes to send that one image. */
+class OutboundQueue : public QObject {
+  Q_OBJECT
+public:
+  enum class Priority { Control, Text, Image };
+
+  struct Limits {
+    // a rate of 0 disables the token bucket altogether.
+    double framesPerSecond = 2;
+    int burst = 5;
+    qint64 maxBytesInFlight = 32 * 1024;
+    // frames which would make the queue grow past this are dropped. counts
+    // the memory taken by the queued strings.
+    qint64 maxQueuedBytes = 8 * 1024 * 1024;
+  };
+
+  explicit OutboundQueue(QWebSocket *socket, QObject *parent = nullptr);
+
+  // returns false if the frame had to be dropped.
+  bool send(const QString &frame, Priority priority);
+  // while held, only control frames are written and everything else waits
+  // in the queue. used while the session isn't logged in.
+  void setHeld(bool held);
+  // to be called when the socket is reopened. whatever was in flight on the
+  // old connection is gone, but queued frames are kept.
+  void resetInFlight() { mBytesInFlight = 0; }
+
+  const Limits &limits() const { return mLimits; }
+  void setLimits(const Limits &limits);
+  // used for all queues created afterwards.
+  static void setDefaultLimits(const Limits &limits);
+  static const Limits &defaultLimits();
+
+signals:
+  void aboutToSend(const QString &frame);
+
+private:
+  bool takeToken();
+  void pump();
+  void write(const QString &frame);
+  void onBytesWritten(qint64 bytes);
+
+  QWebSocket *const mSocket;
+  Limits mLimits;
+  std::array<std::deque<QString>, 2> mQueues; // text and images
+  qint64 mQueuedBytes = 0;
+  qint64 mBytesInFlight = 0;
+  bool mHeld = false;
+  double mTokens;
+  QElapsedTimer mRefillClock;
+  QTimer mRefillTimer;
+};
+
+} // namespace Czateria
+
+#endif // OUTBOUNDQUEUE_H
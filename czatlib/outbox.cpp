@@ -0,0 +1,151 @@
+#include "outbox.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+constexpr auto streamVersion = QDataStream::Qt_5_6;
+constexpr quint32 outboxMagic = 0x637a6f62; // "czob"
+
+QString &directoryStorage() {
+  static QString directory;
+  return directory;
+}
+} // namespace
+
+namespace Czateria {
+
+constexpr qint64 Outbox::maxAge;
+constexpr qint64 Outbox::resubmitWindow;
+
+Outbox::Outbox(const QString &name) : mName(name) { load(); }
+
+bool Outbox::add(Kind kind, const QString &nickname, const QString &text) {
+  const auto now = QDateTime::currentDateTime();
+  const auto resubmitted =
+      std::any_of(std::begin(mItems), std::end(mItems), [&](auto &&item) {
+        return item.kind == kind && item.nickname == nickname &&
+               item.text == text &&
+               item.queuedAt.msecsTo(now) < resubmitWindow;
+      });
+  if (resubmitted) {
+    return false;
+  }
+  mItems.push_back({kind, nickname, text, now});
+  save();
+  return true;
+}
+
+std::vector<Outbox::Item> Outbox::take(int &expired) {
+  const auto now = QDateTime::currentDateTime();
+  std::vector<Item> rv;
+  rv.reserve(mItems.size());
+  expired = 0;
+  for (auto &&item : mItems) {
+    if (item.queuedAt.msecsTo(now) > maxAge) {
+      ++expired;
+    } else {
+      rv.push_back(std::move(item));
+    }
+  }
+  mItems.clear();
+  save();
+  return rv;
+}
+
+void Outbox::rename(const QString &name) {
+  if (name == mName) {
+    return;
+  }
+  if (!directory().isEmpty()) {
+    QFile::remove(path());
+  }
+  mName = name;
+  // a previous session might have left something behind under the new name.
+  load();
+  std::stable_sort(
+      std::begin(mItems), std::end(mItems),
+      [](auto &&a, auto &&b) { return a.queuedAt < b.queuedAt; });
+  save();
+}
+
+void Outbox::setDirectory(const QString &directory) {
+  directoryStorage() = directory;
+}
+
+const QString &Outbox::directory() { return directoryStorage(); }
+
+QString Outbox::path() const {
+  static const QRegularExpression unsafeChars(QLatin1String("[^\\w.@-]"));
+  auto name = mName;
+  name.replace(unsafeChars, QLatin1String("_"));
+  return QString(QLatin1String("%1/%2.outbox")).arg(directory(), name);
+}
+
+void Outbox::load() {
+  if (directory().isEmpty()) {
+    return;
+  }
+  QFile f(path());
+  if (!f.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  QDataStream stream(&f);
+  stream.setVersion(streamVersion);
+  quint32 magic;
+  quint32 count;
+  stream >> magic >> count;
+  if (stream.status() != QDataStream::Ok || magic != outboxMagic) {
+    qInfo() << "Ignoring invalid outbox" << path();
+    return;
+  }
+  for (quint32 i = 0; i < count; ++i) {
+    quint8 kind;
+    Item item;
+    stream >> kind >> item.nickname >> item.text >> item.queuedAt;
+    if (stream.status() != QDataStream::Ok) {
+      qInfo() << "Outbox" << path() << "is truncated";
+      break;
+    }
+    item.kind = static_cast<Kind>(kind);
+    mItems.push_back(std::move(item));
+  }
+  if (!mItems.empty()) {
+    qInfo() << mItems.size() << "messages waiting in outbox" << path();
+  }
+}
+
+void Outbox::save() const {
+  if (directory().isEmpty()) {
+    return;
+  }
+  if (mItems.empty()) {
+    QFile::remove(path());
+    return;
+  }
+  QDir().mkpath(directory());
+  QSaveFile f(path());
+  if (!f.open(QIODevice::WriteOnly)) {
+    qInfo() << "Could not save outbox" << path() << ":" << f.errorString();
+    return;
+  }
+  QDataStream stream(&f);
+  stream.setVersion(streamVersion);
+  stream << outboxMagic << static_cast<quint32>(mItems.size());
+  for (auto &&item : mItems) {
+    stream << static_cast<quint8>(item.kind) << item.nickname << item.text
+           << item.queuedAt;
+  }
+  if (!f.commit()) {
+    qInfo() << "Could not save outbox" << path() << ":" << f.errorString();
+  }
+}
+
+} // namespace Czateria
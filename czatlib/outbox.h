@@ -0,0 +1,61 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <QDateTime>
+#include <QString>
+
+#include <vector>
+
+namespace Czateria {
+
+/* messages the user sent while the session wasn't logged in, waiting to go
+ * out once it is. the outbox is saved to a file named after the session, so
+ * that whatever didn't make it out survives the application going away, and
+ * is picked up by the next session with the same nickname in the same room.
+ * messages get stale quickly in a chat, so whatever waited for too long is
+ * dropped rather than sent. */
+class Outbox {
+public:
+  enum class Kind : quint8 { Room, Private };
+  struct Item {
+    Kind kind;
+    // the recipient of private messages.
+    QString nickname;
+    QString text;
+    QDateTime queuedAt;
+  };
+
+  static constexpr qint64 maxAge = 5 * 60 * 1000;
+  // the same message added again within this long is taken as a resubmit.
+  static constexpr qint64 resubmitWindow = 2000;
+
+  // loads whatever was saved under this name.
+  explicit Outbox(const QString &name);
+
+  // returns false if the very same message was added just before, which is
+  // most likely hitting return again because nothing seemed to happen. the
+  // same message sent later on is simply added again.
+  bool add(Kind kind, const QString &nickname, const QString &text);
+  // everything that's still fresh, in the order it was added.
+  std::vector<Item> take(int &expired);
+  bool isEmpty() const { return mItems.empty(); }
+  // moves the saved outbox along, e.g. when the server assigns a nickname.
+  void rename(const QString &name);
+
+  // where the outboxes are saved. an empty string, the default, keeps them
+  // in memory only.
+  static void setDirectory(const QString &directory);
+  static const QString &directory();
+
+private:
+  QString path() const;
+  void load();
+  void save() const;
+
+  QString mName;
+  std::vector<Item> mItems;
+};
+
+} // namespace Czateria
+
+#endif // OUTBOX_H
@@ -0,0 +1,71 @@
+#include "pendingconnections.h"
+
+#include <QDebug>
+#include <QTimer>
+
+#include "chatconnection.h"
+#include "endpoints.h"
+#include "room.h"
+#include "sessionthreads.h"
+
+namespace Czateria {
+
+constexpr int PendingConnections::expiryTime;
+
+PendingConnections &PendingConnections::instance() {
+  static PendingConnections connections;
+  return connections;
+}
+
+void PendingConnections::open(const Room &room, const QString &nickname,
+                              const ChatBlocker &blocker) {
+  const Key key(room.id, nickname);
+  auto it = mEntries.find(key);
+  if (it != std::end(mEntries)) {
+    discard(key, it->serial);
+  }
+  const auto roomName = room.name;
+  const auto serial = mNextSerial++;
+  auto thread = SessionThreads::instance().acquire();
+  auto connection = new ChatConnection(Endpoints::chatServer(room.port),
+                                       room.name, nickname, blocker, thread);
+  connection->setPaused(true);
+  connect(connection, &ChatConnection::socketError, this,
+          [=](QAbstractSocket::SocketError, const QString &errorString) {
+            qInfo() << "Connection opened ahead for" << roomName
+                    << "failed :" << errorString;
+            discard(key, serial);
+          });
+  QTimer::singleShot(expiryTime, this, [=]() { discard(key, serial); });
+  connection->open();
+  mEntries.insert(key, {connection, thread, serial});
+}
+
+bool PendingConnections::take(const Room &room, const QString &nickname,
+                              ChatConnection *&connection, QThread *&thread) {
+  auto it = mEntries.find(Key(room.id, nickname));
+  if (it == std::end(mEntries)) {
+    return false;
+  }
+  connection = it->connection;
+  thread = it->thread;
+  mEntries.erase(it);
+  connection->disconnect(this);
+  return true;
+}
+
+void PendingConnections::discard(const Key &key, int serial) {
+  auto it = mEntries.find(key);
+  if (it == std::end(mEntries) || it->serial != serial) {
+    // taken over or replaced in the meantime.
+    return;
+  }
+  it->connection->close();
+  it->connection->deleteLater();
+  if (it->thread) {
+    SessionThreads::instance().release(it->thread);
+  }
+  mEntries.erase(it);
+}
+
+} // namespace Czateria
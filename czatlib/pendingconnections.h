@@ -0,0 +1,60 @@
+#ifndef PENDINGCONNECTIONS_H
+#define PENDINGCONNECTIONS_H
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QString>
+
+class QThread;
+
+namespace Czateria {
+
+class ChatBlocker;
+class ChatConnection;
+struct Room;
+
+/* connections opened ahead of the sessions which are going to use them, so
+ * that the TLS and WebSocket handshakes, as well as waiting for the server's
+ * hello, happen while still logging in rather than afterwards. whatever the
+ * server sends is held until a session takes the connection over, which has
+ * to be for the same room and nickname, as the connection decodes what it
+ * receives on behalf of that nickname.
+ * connections which fail, or which nobody takes within a minute, are simply
+ * closed. */
+class PendingConnections : public QObject {
+  Q_OBJECT
+public:
+  static PendingConnections &instance();
+
+  // replaces a connection opened earlier for the same room and nickname, if
+  // any.
+  void open(const Room &room, const QString &nickname,
+            const ChatBlocker &blocker);
+  // on success, the caller becomes responsible for the connection, as well as
+  // for releasing the thread, if it isn't null.
+  bool take(const Room &room, const QString &nickname,
+            ChatConnection *&connection, QThread *&thread);
+
+  static constexpr int expiryTime = 60000;
+
+private:
+  PendingConnections() = default;
+
+  struct Entry {
+    ChatConnection *connection;
+    QThread *thread;
+    int serial;
+  };
+
+  // room id and nickname.
+  using Key = QPair<int, QString>;
+  void discard(const Key &key, int serial);
+
+  QHash<Key, Entry> mEntries;
+  int mNextSerial = 0;
+};
+
+} // namespace Czateria
+
+#endif // PENDINGCONNECTIONS_H
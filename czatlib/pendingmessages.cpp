@@ -0,0 +1,189 @@
+#include "pendingmessages.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <memory>
+#include <set>
+#include <utility>
+
+namespace {
+constexpr auto streamVersion = QDataStream::Qt_5_6;
+
+Czateria::PendingMessages::Limits &defaultLimitsStorage() {
+  static Czateria::PendingMessages::Limits limits;
+  return limits;
+}
+
+// what all the queues have in common.
+struct Shared {
+  qint64 totalBytes = 0;
+  quint64 nextSerial = 0;
+  // every queue which has any messages in memory, by the serial of its
+  // oldest one.
+  std::set<std::pair<quint64, Czateria::PendingMessages *>> oldest;
+  std::unique_ptr<QTemporaryFile> journal;
+  bool journalFailed = false;
+  // the records in the journal which haven't been read back yet. the journal
+  // is only emptied once there are none, so what's been read back still
+  // counts towards its size until then.
+  int liveRecords = 0;
+};
+
+Shared &shared() {
+  static Shared s;
+  return s;
+}
+
+qint64 messageSize(const Czateria::Message &msg) {
+  // close enough. what matters is that long messages count for more.
+  return static_cast<qint64>(sizeof(Czateria::Message)) +
+         msg.rawMessageUtf8().size() + 2 * msg.nickname().size();
+}
+} // namespace
+
+namespace Czateria {
+
+PendingMessages::PendingMessages() : mLimits(defaultLimits()) {}
+
+PendingMessages::~PendingMessages() {
+  auto &s = shared();
+  if (!mMessages.empty()) {
+    s.oldest.erase({mMessages.front().serial, this});
+  }
+  s.totalBytes -= mBytes;
+  forgetSpilled();
+}
+
+void PendingMessages::push(const Message &msg) {
+  auto &s = shared();
+  const auto serial = s.nextSerial++;
+  if (mMessages.empty()) {
+    s.oldest.insert({serial, this});
+  }
+  const auto size = messageSize(msg);
+  mMessages.push_back({serial, msg});
+  mBytes += size;
+  s.totalBytes += size;
+  while (!mMessages.empty() && mBytes > mLimits.maxBytes) {
+    evictOldest();
+  }
+  // whichever conversation holds the oldest messages gives them up first,
+  // rather than the one which happened to receive this one.
+  while (!s.oldest.empty() && s.totalBytes > mLimits.maxTotalBytes) {
+    s.oldest.begin()->second->evictOldest();
+  }
+}
+
+QVector<Message> PendingMessages::takeAll(int &dropped) {
+  auto &s = shared();
+  QVector<Message> rv;
+  rv.reserve(mSpilledAt.size() + static_cast<int>(mMessages.size()));
+  if (!mSpilledAt.isEmpty()) {
+    QDataStream stream(s.journal.get());
+    stream.setVersion(streamVersion);
+    for (auto offset : mSpilledAt) {
+      s.journal->seek(offset);
+      qint64 receivedAt;
+      QByteArray text;
+      QString nickname;
+      stream >> receivedAt >> text >> nickname;
+      if (stream.status() != QDataStream::Ok) {
+        qInfo() << "Could not read back spilled messages from"
+                << s.journal->fileName();
+        break;
+      }
+      rv.push_back(Message::fromUtf8(
+          QDateTime::fromMSecsSinceEpoch(receivedAt), text, nickname));
+    }
+    forgetSpilled();
+  }
+  if (!mMessages.empty()) {
+    s.oldest.erase({mMessages.front().serial, this});
+  }
+  for (auto &&pending : mMessages) {
+    rv.push_back(pending.msg);
+  }
+  mMessages.clear();
+  s.totalBytes -= mBytes;
+  mBytes = 0;
+  dropped = mDropped;
+  mDropped = 0;
+  return rv;
+}
+
+void PendingMessages::setDefaultLimits(const Limits &limits) {
+  defaultLimitsStorage() = limits;
+}
+
+const PendingMessages::Limits &PendingMessages::defaultLimits() {
+  return defaultLimitsStorage();
+}
+
+qint64 PendingMessages::totalBytes() { return shared().totalBytes; }
+
+void PendingMessages::evictOldest() {
+  auto &s = shared();
+  s.oldest.erase({mMessages.front().serial, this});
+  const auto msg = std::move(mMessages.front().msg);
+  mMessages.pop_front();
+  if (!mMessages.empty()) {
+    s.oldest.insert({mMessages.front().serial, this});
+  }
+  const auto size = messageSize(msg);
+  mBytes -= size;
+  s.totalBytes -= size;
+  if (mLimits.overflow != Overflow::Spill || !spill(msg)) {
+    ++mDropped;
+  }
+}
+
+bool PendingMessages::spill(const Message &msg) {
+  auto &s = shared();
+  if (s.journalFailed) {
+    return false;
+  }
+  if (!s.journal) {
+    s.journal = std::make_unique<QTemporaryFile>(
+        QDir::tempPath() + QLatin1String("/czateria-pending-XXXXXX"));
+    if (!s.journal->open()) {
+      qInfo() << "Could not open a journal for pending messages :"
+              << s.journal->errorString();
+      // dropping everything from now on.
+      s.journalFailed = true;
+      s.journal.reset();
+      return false;
+    }
+  }
+  const auto offset = s.journal->size();
+  if (offset >= mLimits.maxJournalBytes) {
+    return false;
+  }
+  s.journal->seek(offset);
+  QDataStream stream(s.journal.get());
+  stream.setVersion(streamVersion);
+  stream << msg.receivedAt().toMSecsSinceEpoch() << msg.rawMessageUtf8()
+         << msg.nickname();
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+  mSpilledAt.push_back(offset);
+  ++s.liveRecords;
+  return true;
+}
+
+void PendingMessages::forgetSpilled() {
+  if (mSpilledAt.isEmpty()) {
+    return;
+  }
+  auto &s = shared();
+  s.liveRecords -= mSpilledAt.size();
+  mSpilledAt.clear();
+  if (s.liveRecords == 0) {
+    s.journal->resize(0);
+  }
+}
+
+} // namespace Czateria
@@ -0,0 +1,70 @@
+#ifndef PENDINGMESSAGES_H
+#define PENDINGMESSAGES_H
+
+#include <QVector>
+
+#include <deque>
+
+#include "message.h"
+
+namespace Czateria {
+
+/* messages of a private conversation which hasn't been accepted yet. they're
+ * kept within a budget of their own, as well as within one shared by all the
+ * conversations, so that a pile of unanswered invites can't eat up memory.
+ * whatever goes over budget is either dropped or moved to a journal on disk,
+ * oldest first. going over the shared budget evicts the oldest messages of
+ * all the conversations, wherever they are. the journal is shared as well,
+ * so that it's a single file however many conversations spill into it. to
+ * be used from the main thread only. */
+class PendingMessages {
+public:
+  enum class Overflow { DropOldest, Spill };
+
+  struct Limits {
+    qint64 maxBytes = 64 * 1024;
+    qint64 maxTotalBytes = 4 * 1024 * 1024;
+    Overflow overflow = Overflow::Spill;
+    // messages which would make the shared journal grow past this are
+    // dropped.
+    qint64 maxJournalBytes = 1024 * 1024;
+  };
+
+  PendingMessages();
+  ~PendingMessages();
+  PendingMessages(const PendingMessages &) = delete;
+  PendingMessages &operator=(const PendingMessages &) = delete;
+
+  void push(const Message &msg);
+  // everything that's left, in the order it was received, along with the
+  // number of messages which were dropped.
+  QVector<Message> takeAll(int &dropped);
+
+  // used for all queues created afterwards.
+  static void setDefaultLimits(const Limits &limits);
+  static const Limits &defaultLimits();
+  // across all the queues.
+  static qint64 totalBytes();
+
+private:
+  struct Pending {
+    // tells apart the oldest messages of all the queues.
+    quint64 serial;
+    Message msg;
+  };
+
+  void evictOldest();
+  bool spill(const Message &msg);
+  void forgetSpilled();
+
+  const Limits mLimits;
+  std::deque<Pending> mMessages;
+  qint64 mBytes = 0;
+  int mDropped = 0;
+  // where the spilled messages are in the journal, oldest first.
+  QVector<qint64> mSpilledAt;
+};
+
+} // namespace Czateria
+
+#endif // PENDINGMESSAGES_H
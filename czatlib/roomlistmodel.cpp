@@ -9,6 +9,8 @@
 #include <algorithm>
 #include <type_traits>
 
+#include "endpoints.h"
+
 namespace {
 using namespace Czateria;
 const QStringList &model_columns() {
@@ -29,8 +31,7 @@ RoomListModel::RoomListModel(QObject *parent, QNetworkAccessManager *nam,
 }
 
 void RoomListModel::download() {
-  mReply = mNAM->get(QNetworkRequest(
-      QUrl(QLatin1String("https://czateria.interia.pl/rooms-list"))));
+  mReply = mNAM->get(QNetworkRequest(Endpoints::roomList()));
   connect(mReply, &QNetworkReply::finished, this,
           &RoomListModel::onDownloadFinished);
   void (QNetworkReply::*errSignal)(QNetworkReply::NetworkError) =
@@ -0,0 +1,141 @@
+#include "sessionmanager.h"
+
+#include <QDebug>
+#include <QSet>
+
+#include <algorithm>
+#include <iterator>
+
+#include "chatsession.h"
+#include "loginsession.h"
+#include "userlistmodel.h"
+
+namespace {
+// managers only ever live on the main thread, and so does dumping them.
+QSet<Czateria::SessionManager *> &liveManagers() {
+  static QSet<Czateria::SessionManager *> managers;
+  return managers;
+}
+} // namespace
+
+namespace Czateria {
+
+SessionManager::SessionManager(QNetworkAccessManager *nam,
+                               const ChatBlocker &blocker, QObject *parent)
+    : QObject(parent), mNAM(nam), mAvatars(nam), mBlocker(blocker) {
+  liveManagers().insert(this);
+}
+
+SessionManager::~SessionManager() {
+  liveManagers().remove(this);
+  // while the avatars are still there.
+  qDeleteAll(
+      findChildren<ChatSession *>(QString(), Qt::FindDirectChildrenOnly));
+}
+
+void SessionManager::addListener(ChatSessionListener *listener) {
+  mListeners.push_back(listener);
+}
+
+void SessionManager::removeListener(ChatSessionListener *listener) {
+  mListeners.erase(
+      std::remove(std::begin(mListeners), std::end(mListeners), listener),
+      std::end(mListeners));
+}
+
+LoginSession *SessionManager::createLoginSession() {
+  return new LoginSession(mNAM);
+}
+
+QSharedPointer<LoginSession>
+SessionManager::loginSession(const QString &nickname) const {
+  return mLoginSessions.value(nickname).toStrongRef();
+}
+
+ChatSession *SessionManager::createChatSession(
+    QSharedPointer<LoginSession> login, const Room &room, QObject *parent) {
+  if (!login->nickname().isEmpty()) {
+    mLoginSessions[login->nickname()] = login.toWeakRef();
+  }
+  auto session = new ChatSession(login, mAvatars, room, mBlocker, this,
+                                 parent ? parent : this);
+  mChatSessions.push_back(session);
+  connect(session, &QObject::destroyed, this, [=]() {
+    mChatSessions.removeOne(session);
+    // done with whatever is left of the login sessions.
+    for (auto it = std::begin(mLoginSessions);
+         it != std::end(mLoginSessions);) {
+      it = it->isNull() ? mLoginSessions.erase(it) : std::next(it);
+    }
+    emit chatSessionDestroyed(session);
+  });
+  emit chatSessionCreated(session);
+  return session;
+}
+
+SessionManager::Stats SessionManager::stats() const {
+  auto stats = mCounters;
+  stats.loginSessions = static_cast<int>(
+      std::count_if(std::begin(mLoginSessions), std::end(mLoginSessions),
+                    [](auto &&login) { return !login.isNull(); }));
+  stats.chatSessions = mChatSessions.size();
+  for (auto session : mChatSessions) {
+    stats.users += session->userListModel()->rowCount();
+  }
+  return stats;
+}
+
+void SessionManager::dumpAll() {
+  for (auto manager : liveManagers()) {
+    const auto stats = manager->stats();
+    qInfo().nospace() << "Sessions : login=" << stats.loginSessions
+                      << " chat=" << stats.chatSessions
+                      << " users=" << stats.users
+                      << " room_messages=" << stats.roomMessages
+                      << " priv_received=" << stats.privateMessagesReceived
+                      << " priv_sent=" << stats.privateMessagesSent
+                      << " joins=" << stats.joins << " parts=" << stats.parts;
+  }
+}
+
+void SessionManager::onRoomMessage(const ChatSession *session,
+                                   const Message &message) {
+  ++mCounters.roomMessages;
+  for (auto listener : mListeners) {
+    listener->onRoomMessage(session, message);
+  }
+}
+
+void SessionManager::onPrivateMessageReceived(const ChatSession *session,
+                                              const Message &message) {
+  ++mCounters.privateMessagesReceived;
+  for (auto listener : mListeners) {
+    listener->onPrivateMessageReceived(session, message);
+  }
+}
+
+void SessionManager::onPrivateMessageSent(const ChatSession *session,
+                                          const Message &message) {
+  ++mCounters.privateMessagesSent;
+  for (auto listener : mListeners) {
+    listener->onPrivateMessageSent(session, message);
+  }
+}
+
+void SessionManager::onUserJoined(const ChatSession *session,
+                                  const QString &nickname) {
+  ++mCounters.joins;
+  for (auto listener : mListeners) {
+    listener->onUserJoined(session, nickname);
+  }
+}
+
+void SessionManager::onUserLeft(const ChatSession *session,
+                                const QString &nickname) {
+  ++mCounters.parts;
+  for (auto listener : mListeners) {
+    listener->onUserLeft(session, nickname);
+  }
+}
+
+} // namespace Czateria
@@ -0,0 +1,102 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QWeakPointer>
+
+#include <vector>
+
+#include "avatarhandler.h"
+#include "chatsessionlistener.h"
+
+class QNetworkAccessManager;
+
+namespace Czateria {
+
+class ChatBlocker;
+class ChatSession;
+class LoginSession;
+struct Room;
+
+/* creates and keeps track of the login and chat sessions of the process, so
+ * that whatever the sessions have in common is there once rather than once
+ * per room : the avatars, the blocker, and the listeners, which get called
+ * for all the sessions. the keepalives, the worker threads and the TLS
+ * tickets are shared by their own singletons already.
+ * it doesn't need any widgets, so that it can just as well run headless. */
+class SessionManager : public QObject, private ChatSessionListener {
+  Q_OBJECT
+public:
+  SessionManager(QNetworkAccessManager *nam, const ChatBlocker &blocker,
+                 QObject *parent = nullptr);
+  ~SessionManager() override;
+
+  AvatarHandler &avatars() { return mAvatars; }
+  const ChatBlocker &blocker() const { return mBlocker; }
+
+  // the listeners aren't owned, and need to outlive the sessions.
+  void addListener(ChatSessionListener *listener);
+  void removeListener(ChatSessionListener *listener);
+
+  // the caller is responsible for the session until it logs in successfully
+  // and is handed over to createChatSession().
+  LoginSession *createLoginSession();
+  // the logged in session of a given nickname, as long as any chat session
+  // is still using it.
+  QSharedPointer<LoginSession> loginSession(const QString &nickname) const;
+
+  // the chat session is owned by the parent, if there's one, and by the
+  // manager otherwise. either way, it's tracked until it's deleted.
+  ChatSession *createChatSession(QSharedPointer<LoginSession> login,
+                                 const Room &room, QObject *parent = nullptr);
+  const QList<ChatSession *> &chatSessions() const { return mChatSessions; }
+
+  struct Stats {
+    int loginSessions = 0;
+    int chatSessions = 0;
+    // summed up over all the rooms, so users in several rooms count more
+    // than once.
+    int users = 0;
+    // all of these include the messages sent.
+    qint64 roomMessages = 0;
+    qint64 privateMessagesReceived = 0;
+    qint64 privateMessagesSent = 0;
+    qint64 joins = 0;
+    qint64 parts = 0;
+  };
+  Stats stats() const;
+  // logs the statistics of all the managers in the process.
+  static void dumpAll();
+
+signals:
+  void chatSessionCreated(Czateria::ChatSession *session);
+  void chatSessionDestroyed(Czateria::ChatSession *session);
+
+private:
+  void onRoomMessage(const ChatSession *session,
+                     const Message &message) override;
+  void onPrivateMessageReceived(const ChatSession *session,
+                                const Message &message) override;
+  void onPrivateMessageSent(const ChatSession *session,
+                            const Message &message) override;
+  void onUserJoined(const ChatSession *session,
+                    const QString &nickname) override;
+  void onUserLeft(const ChatSession *session,
+                  const QString &nickname) override;
+
+  QNetworkAccessManager *const mNAM;
+  AvatarHandler mAvatars;
+  const ChatBlocker &mBlocker;
+  std::vector<ChatSessionListener *> mListeners;
+  QHash<QString, QWeakPointer<LoginSession>> mLoginSessions;
+  QList<ChatSession *> mChatSessions;
+  Stats mCounters;
+};
+
+} // namespace Czateria
+
+#endif // SESSIONMANAGER_H
@@ -0,0 +1,119 @@
+#include "sessionmetrics.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSet>
+
+#include <algorithm>
+#include <iterator>
+
+#include "wiretrace.h"
+
+namespace {
+QMutex liveMetricsMutex;
+
+QSet<Czateria::SessionMetrics *> &liveMetrics() {
+  static QSet<Czateria::SessionMetrics *> metrics;
+  return metrics;
+}
+
+QString describe(const QString &name,
+                 const Czateria::LatencyHistogram &histogram) {
+  return QString(QLatin1String("%1 samples=%2 p50=%3 p99=%4"))
+      .arg(name)
+      .arg(histogram.count())
+      .arg(histogram.percentile(50))
+      .arg(histogram.percentile(99));
+}
+} // namespace
+
+namespace Czateria {
+
+constexpr int LatencyHistogram::windowSize;
+
+void LatencyHistogram::add(qint64 msecs) {
+  constexpr auto size = static_cast<std::size_t>(windowSize);
+  QMutexLocker lock(&mMutex);
+  if (mSamples.size() < size) {
+    mSamples.push_back(msecs);
+  } else {
+    mSamples[mNext] = msecs;
+  }
+  mNext = (mNext + 1) % size;
+}
+
+int LatencyHistogram::count() const {
+  QMutexLocker lock(&mMutex);
+  return static_cast<int>(mSamples.size());
+}
+
+qint64 LatencyHistogram::percentile(int p) const {
+  QMutexLocker lock(&mMutex);
+  if (mSamples.empty()) {
+    return -1;
+  }
+  auto samples = mSamples;
+  lock.unlock();
+  const auto rank = (samples.size() - 1) * static_cast<std::size_t>(p) / 100;
+  auto nth = std::next(std::begin(samples), static_cast<std::ptrdiff_t>(rank));
+  std::nth_element(std::begin(samples), nth, std::end(samples));
+  return *nth;
+}
+
+SessionMetrics::SessionMetrics() {
+  QMutexLocker lock(&liveMetricsMutex);
+  liveMetrics().insert(this);
+}
+
+SessionMetrics::~SessionMetrics() {
+  QMutexLocker lock(&liveMetricsMutex);
+  liveMetrics().remove(this);
+}
+
+void SessionMetrics::setLabel(const QString &label) {
+  QMutexLocker lock(&mMutex);
+  mLabel = label;
+}
+
+QString SessionMetrics::label() const {
+  QMutexLocker lock(&mMutex);
+  return mLabel;
+}
+
+bool SessionMetrics::dump(QIODevice *out) const {
+  const auto line =
+      QString(QLatin1String("%1 : %2, %3\n"))
+          .arg(label(), describe(QLatin1String("echo_rtt_ms"), echoRtt),
+               describe(QLatin1String("pong_rtt_ms"), pongRtt))
+          .toUtf8();
+  return out->write(line) == line.size();
+}
+
+void SessionMetrics::dumpAll() {
+  const auto &directory = WireTrace::dumpDirectory();
+  if (directory.isEmpty()) {
+    return;
+  }
+  QDir().mkpath(directory);
+  const auto path = QString(QLatin1String("%1/metrics-%2.log"))
+                        .arg(directory, QDateTime::currentDateTime().toString(
+                                            QLatin1String("yyyyMMdd-HHmmss")));
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly)) {
+    qInfo() << "Could not write session metrics to" << path;
+    return;
+  }
+  QMutexLocker lock(&liveMetricsMutex);
+  for (auto metrics : liveMetrics()) {
+    if (!metrics->dump(&f)) {
+      qInfo() << "Could not write session metrics to" << path;
+      return;
+    }
+  }
+  qInfo() << "Session metrics written to" << path;
+}
+
+} // namespace Czateria
@@ -0,0 +1,64 @@
+#ifndef SESSIONMETRICS_H
+#define SESSIONMETRICS_H
+
+#include <QMutex>
+#include <QString>
+
+#include <vector>
+
+class QIODevice;
+
+namespace Czateria {
+
+/* the latest latency samples of some kind, in milliseconds. only a window of
+ * them is kept, so that the percentiles follow whatever the conditions are
+ * right now rather than averaging over the whole session. */
+class LatencyHistogram {
+public:
+  static constexpr int windowSize = 256;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  void add(qint64 msecs);
+  int count() const;
+  // p goes from 0 to 100. returns -1 while there are no samples.
+  qint64 percentile(int p) const;
+
+private:
+  mutable QMutex mMutex;
+  std::vector<qint64> mSamples;
+  std::size_t mNext = 0;
+};
+
+/* whatever is measured about a session. these are written out along with the
+ * wire traces, and they may be updated from the connection's thread. */
+class SessionMetrics {
+public:
+  SessionMetrics();
+  ~SessionMetrics();
+  SessionMetrics(const SessionMetrics &) = delete;
+  SessionMetrics &operator=(const SessionMetrics &) = delete;
+
+  void setLabel(const QString &label);
+  QString label() const;
+
+  // from sending a room message until the server echoes it back.
+  LatencyHistogram echoRtt;
+  // WebSocket pings, answered by the server's transport layer alone.
+  LatencyHistogram pongRtt;
+
+  bool dump(QIODevice *out) const;
+  // writes all the sessions' metrics to a new file in the wire traces' dump
+  // directory.
+  static void dumpAll();
+
+private:
+  QString mLabel;
+  mutable QMutex mMutex;
+};
+
+} // namespace Czateria
+
+#endif // SESSIONMETRICS_H
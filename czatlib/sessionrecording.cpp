@@ -0,0 +1,89 @@
+#include "sessionrecording.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QRegularExpression>
+
+namespace {
+constexpr quint32 recordingMagic = 0x637a7263; // "czrc"
+constexpr quint32 recordingVersion = 1;
+// fixed, so that recordings made with one Qt version can be replayed with
+// another.
+constexpr auto streamVersion = QDataStream::Qt_5_6;
+
+QString &recordDirectoryStorage() {
+  static QString directory;
+  return directory;
+}
+} // namespace
+
+namespace Czateria {
+
+SessionRecorder::SessionRecorder(const QString &path, const QString &roomName,
+                                 const QString &nickname)
+    : mPath(path), mFile(path) {
+  if (!mFile.open(QIODevice::WriteOnly)) {
+    qInfo() << "Could not open" << path << "for recording the session";
+    return;
+  }
+  mStream.setDevice(&mFile);
+  mStream.setVersion(streamVersion);
+  mStream << recordingMagic << recordingVersion << roomName << nickname;
+  mClock.start();
+}
+
+void SessionRecorder::record(const QByteArray &frame) {
+  if (!isOpen()) {
+    return;
+  }
+  mStream << mClock.elapsed() << frame;
+  // a session usually ends with the application being closed in one way or
+  // another, so nothing is left waiting in the buffer.
+  mFile.flush();
+}
+
+void SessionRecorder::setRecordDirectory(const QString &directory) {
+  recordDirectoryStorage() = directory;
+}
+
+const QString &SessionRecorder::recordDirectory() {
+  return recordDirectoryStorage();
+}
+
+QString SessionRecorder::pathForRoom(const QString &directory,
+                                     const QString &roomName) {
+  static const QRegularExpression unsafeChars(QLatin1String("[^\\w.@-]"));
+  auto name = roomName;
+  name.replace(unsafeChars, QLatin1String("_"));
+  QDir().mkpath(directory);
+  return QString(QLatin1String("%1/%2-%3.czrec"))
+      .arg(directory, name,
+           QDateTime::currentDateTime().toString(
+               QLatin1String("yyyyMMdd-HHmmss-zzz")));
+}
+
+SessionRecordingReader::SessionRecordingReader(const QString &path)
+    : mFile(path) {
+  if (!mFile.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  mStream.setDevice(&mFile);
+  mStream.setVersion(streamVersion);
+  quint32 magic, version;
+  mStream >> magic >> version >> mRoomName >> mNickname;
+  mValid = mStream.status() == QDataStream::Ok && magic == recordingMagic &&
+           version == recordingVersion;
+}
+
+bool SessionRecordingReader::next(qint64 &elapsed, QByteArray &frame) {
+  if (!mValid || mStream.atEnd()) {
+    return false;
+  }
+  mStream >> elapsed >> frame;
+  // a truncated last record is to be expected if the application crashed.
+  mValid = mStream.status() == QDataStream::Ok;
+  return mValid;
+}
+
+} // namespace Czateria
@@ -0,0 +1,58 @@
+#ifndef SESSIONRECORDING_H
+#define SESSIONRECORDING_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+namespace Czateria {
+
+/* a complete, untruncated recording of everything a session receives from the
+ * server, meant to be fed back into a ChatSession by the replay tool. unlike
+ * WireTrace, this is opt-in : recordings contain private conversations in
+ * full, and grow without bounds. */
+class SessionRecorder {
+public:
+  SessionRecorder(const QString &path, const QString &roomName,
+                  const QString &nickname);
+
+  bool isOpen() const { return mFile.isOpen(); }
+  const QString &path() const { return mPath; }
+  void record(const QByteArray &frame);
+
+  // where sessions save their recordings. an empty string, the default,
+  // disables recording altogether.
+  static void setRecordDirectory(const QString &directory);
+  static const QString &recordDirectory();
+  static QString pathForRoom(const QString &directory, const QString &roomName);
+
+private:
+  const QString mPath;
+  QFile mFile;
+  QDataStream mStream;
+  QElapsedTimer mClock;
+};
+
+class SessionRecordingReader {
+public:
+  explicit SessionRecordingReader(const QString &path);
+
+  bool isValid() const { return mValid; }
+  const QString &roomName() const { return mRoomName; }
+  const QString &nickname() const { return mNickname; }
+  // elapsed is the time since the start of the recording, in milliseconds.
+  bool next(qint64 &elapsed, QByteArray &frame);
+
+private:
+  QFile mFile;
+  QDataStream mStream;
+  QString mRoomName;
+  QString mNickname;
+  bool mValid = false;
+};
+
+} // namespace Czateria
+
+#endif // SESSIONRECORDING_H
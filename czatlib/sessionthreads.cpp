@@ -0,0 +1,59 @@
+#include "sessionthreads.h"
+
+#include <QString>
+#include <QThread>
+
+#include <algorithm>
+#include <iterator>
+
+namespace Czateria {
+
+SessionThreads &SessionThreads::instance() {
+  static SessionThreads threads;
+  return threads;
+}
+
+SessionThreads::~SessionThreads() {
+  // whatever connections are still around get deleted once their thread's
+  // event loop is done.
+  for (auto &&worker : mWorkers) {
+    worker.thread->quit();
+  }
+  for (auto &&worker : mWorkers) {
+    worker.thread->wait();
+  }
+}
+
+QThread *SessionThreads::acquire() {
+  if (mSessionsPerThread <= 0) {
+    return nullptr;
+  }
+  auto it = std::min_element(
+      std::begin(mWorkers), std::end(mWorkers),
+      [](auto &&a, auto &&b) { return a.sessions < b.sessions; });
+  const auto maxThreads = std::max(QThread::idealThreadCount(), 1);
+  if (it == std::end(mWorkers) ||
+      (it->sessions >= mSessionsPerThread &&
+       static_cast<int>(mWorkers.size()) < maxThreads)) {
+    Worker worker{std::make_unique<QThread>(), 0};
+    worker.thread->setObjectName(QString(QLatin1String("czateria-io-%1"))
+                                     .arg(static_cast<int>(mWorkers.size())));
+    worker.thread->start();
+    mWorkers.push_back(std::move(worker));
+    it = std::prev(std::end(mWorkers));
+  }
+  ++it->sessions;
+  return it->thread.get();
+}
+
+void SessionThreads::release(QThread *thread) {
+  auto it = std::find_if(
+      std::begin(mWorkers), std::end(mWorkers),
+      [=](auto &&worker) { return worker.thread.get() == thread; });
+  Q_ASSERT(it != std::end(mWorkers));
+  if (it != std::end(mWorkers)) {
+    --it->sessions;
+  }
+}
+
+} // namespace Czateria
@@ -0,0 +1,45 @@
+#ifndef SESSIONTHREADS_H
+#define SESSIONTHREADS_H
+
+#include <memory>
+#include <vector>
+
+class QThread;
+
+namespace Czateria {
+
+/* the worker threads which sessions' connections can run on, so that a busy
+ * room doesn't keep the GUI thread, and therefore every other room, waiting.
+ * each thread takes up to sessionsPerThread sessions before another one is
+ * started, up to one per core. once all of them are full, sessions go to
+ * whichever thread has the least of them.
+ * disabled by default, in which case everything runs on the GUI thread. only
+ * to be used from the GUI thread. */
+class SessionThreads {
+public:
+  static SessionThreads &instance();
+  ~SessionThreads();
+
+  // 0 disables the threads. only affects sessions created afterwards.
+  void setSessionsPerThread(int count) { mSessionsPerThread = count; }
+  int sessionsPerThread() const { return mSessionsPerThread; }
+
+  // returns null if the threads are disabled.
+  QThread *acquire();
+  void release(QThread *thread);
+
+private:
+  SessionThreads() = default;
+
+  struct Worker {
+    std::unique_ptr<QThread> thread;
+    int sessions;
+  };
+
+  std::vector<Worker> mWorkers;
+  int mSessionsPerThread = 0;
+};
+
+} // namespace Czateria
+
+#endif // SESSIONTHREADS_H
@@ -0,0 +1,107 @@
+#include "tlssessioncache.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSslConfiguration>
+#include <QSslSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QWebSocket>
+
+namespace {
+QSslConfiguration configuration(const QByteArray &ticket) {
+  auto config = QSslConfiguration::defaultConfiguration();
+  // without this, there's no ticket to be had from the socket.
+  config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+  if (!ticket.isEmpty()) {
+    config.setSessionTicket(ticket);
+  }
+  return config;
+}
+
+constexpr int ticketWaitTime = 2000;
+
+bool isEncrypted(const QUrl &url) {
+  return url.scheme() == QLatin1String("wss");
+}
+} // namespace
+
+namespace Czateria {
+
+constexpr qint64 TlsSessionCache::warmUpInterval;
+constexpr int TlsSessionCache::warmUpTimeout;
+
+TlsSessionCache &TlsSessionCache::instance() {
+  static TlsSessionCache cache;
+  return cache;
+}
+
+TlsSessionCache::TlsSessionCache() { mClock.start(); }
+
+void TlsSessionCache::prepare(QWebSocket *socket, const QUrl &url) {
+  if (!isEncrypted(url)) {
+    return;
+  }
+  QMutexLocker lock(&mMutex);
+  socket->setSslConfiguration(configuration(mTickets.value(url.host())));
+}
+
+void TlsSessionCache::warmUp(const QUrl &url) {
+  if (!isEncrypted(url)) {
+    return;
+  }
+  const auto host = url.host();
+  QByteArray ticket;
+  {
+    QMutexLocker lock(&mMutex);
+    const auto now = mClock.elapsed();
+    auto it = mLastWarmUp.find(host);
+    if (it != std::end(mLastWarmUp) && now - *it < warmUpInterval) {
+      return;
+    }
+    mLastWarmUp[host] = now;
+    ticket = mTickets.value(host);
+  }
+  auto socket = new QSslSocket;
+  QObject::connect(socket, &QSslSocket::encrypted, socket, [=]() {
+    store(host, socket->sslConfiguration().sessionTicket());
+    // with TLS 1.3, the ticket only arrives after the handshake.
+    QTimer::singleShot(ticketWaitTime, socket,
+                       [=]() { socket->disconnectFromHost(); });
+  });
+  QObject::connect(socket, &QSslSocket::disconnected, socket, [=]() {
+    store(host, socket->sslConfiguration().sessionTicket());
+    socket->deleteLater();
+  });
+  void (QSslSocket::*errSig)(QAbstractSocket::SocketError) =
+      &QSslSocket::error;
+  QObject::connect(socket, errSig, socket,
+                   [=](QAbstractSocket::SocketError err) {
+                     if (err != QAbstractSocket::RemoteHostClosedError) {
+                       qInfo() << "Could not warm up" << host << ":"
+                               << socket->errorString();
+                     }
+                     socket->deleteLater();
+                   });
+  QTimer::singleShot(warmUpTimeout, socket, [=]() {
+    socket->abort();
+    socket->deleteLater();
+  });
+  socket->setSslConfiguration(configuration(ticket));
+  socket->connectToHostEncrypted(host, static_cast<quint16>(url.port(443)));
+}
+
+bool TlsSessionCache::hasTicket(const QUrl &url) {
+  QMutexLocker lock(&mMutex);
+  return mTickets.contains(url.host());
+}
+
+void TlsSessionCache::store(const QString &host, const QByteArray &ticket) {
+  if (ticket.isEmpty()) {
+    return;
+  }
+  QMutexLocker lock(&mMutex);
+  mTickets[host] = ticket;
+}
+
+} // namespace Czateria
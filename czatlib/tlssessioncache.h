@@ -0,0 +1,53 @@
+#ifndef TLSSESSIONCACHE_H
+#define TLSSESSIONCACHE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+class QUrl;
+class QWebSocket;
+
+namespace Czateria {
+
+/* TLS session tickets of the chat servers, shared by all the connections, so
+ * that reconnecting to a room's server resumes a session instead of going
+ * through a full handshake.
+ * QWebSocket takes a ticket, but never hands out the one it got, so the
+ * tickets come from warmUp() instead. it resolves the host and goes through
+ * the handshake on a plain QSslSocket, without ever opening a WebSocket.
+ * a ticket already cached is used for that handshake too, so refreshing it
+ * doesn't cost a full one.
+ * safe to use from any thread, as the connections may run on worker
+ * threads. */
+class TlsSessionCache {
+public:
+  static TlsSessionCache &instance();
+
+  // to be called before opening the socket.
+  void prepare(QWebSocket *socket, const QUrl &url);
+  // does nothing for unencrypted URLs. needs an event loop running on the
+  // calling thread.
+  void warmUp(const QUrl &url);
+  bool hasTicket(const QUrl &url);
+
+  // warming up a host which was warmed up this recently, or is being warmed
+  // up right now, is skipped.
+  static constexpr qint64 warmUpInterval = 5 * 60 * 1000;
+  static constexpr int warmUpTimeout = 30000;
+
+private:
+  TlsSessionCache();
+  void store(const QString &host, const QByteArray &ticket);
+
+  QMutex mMutex;
+  QHash<QString, QByteArray> mTickets;
+  QHash<QString, qint64> mLastWarmUp;
+  QElapsedTimer mClock;
+};
+
+} // namespace Czateria
+
+#endif // TLSSESSIONCACHE_H
@@ -1,67 +1,48 @@
 #include "user.h"
 
-#include <QJsonObject>
+namespace Czateria {
+
+UserCard::Sex UserCard::sexFromString(const QString &sex) {
+  if (sex == QLatin1String("M")) {
+    return Sex::Male;
+  } else if (sex == QLatin1String("F")) {
+    return Sex::Female;
+  } else if (sex == QLatin1String("B")) {
+    return Sex::Both;
+  } else {
+    return Sex::Unspecified;
+  }
+}
 
-namespace {
-Czateria::User::Type permToUserType(int perm) {
-  using t = Czateria::User::Type;
+User::Type User::typeFromPerm(int perm) {
   switch (perm) {
   case 0:
-    return t::Guest;
+    return Type::Guest;
   case 1:
   case 2:
-    return t::Registered;
+    return Type::Registered;
   case 3:
-    return t::Admin;
+    return Type::Admin;
   case 4:
-    return t::SuperAdmin;
+    return Type::SuperAdmin;
   case 5:
-    return t::Honoured;
-  }
-  return t::Guest;
-}
-
-Czateria::User::Sex sexToUserSex(const QString &sex) {
-  using sx = Czateria::User::Sex;
-  if (sex == QLatin1String("M")) {
-    return sx::Male;
-  } else if (sex == QLatin1String("F")) {
-    return sx::Female;
-  } else if (sex == QLatin1String("B")) {
-    return sx::Both;
-  } else {
-    return sx::Unspecified;
+    return Type::Honoured;
   }
+  return Type::Guest;
 }
-} // namespace
-
-namespace Czateria {
-
-User::User(const QJsonObject &basicInfo, const QJsonObject &cardInfo)
-    : User(basicInfo) {
-  updateCardInfo(cardInfo);
-}
-
-User::User(const QJsonObject &basicInfo)
-    : mLogin(basicInfo[QLatin1String("login")].toString()),
-      mEmotion(basicInfo[QLatin1String("emotion")].toInt()),
-      mMobileUser(basicInfo[QLatin1String("isMobileUser")].toBool()),
-      mHasPrivs(basicInfo[QLatin1String("privs")].toInt() > 0),
-      mType(permToUserType(basicInfo[QLatin1String("perm")].toInt())) {}
 
-void User::updateCardInfo(const QJsonObject &cardInfo) {
-  mDescription = cardInfo[QLatin1String("description")].toString();
-  mAvatarId = cardInfo[QLatin1String("avatarId")].toString();
-  mBirthDate = QDate::fromString(cardInfo[QLatin1String("bornDate")].toString(),
-                                 QLatin1String("dd-MM-yyyy"));
-  mUid = cardInfo[QLatin1String("uid")].toInt();
-  mLatitude = cardInfo[QLatin1String("lat")].toInt();
-  mLongitude = cardInfo[QLatin1String("lon")].toInt();
-  mToken = cardInfo[QLatin1String("token")].toString();
-  mAgeFrom = cardInfo[QLatin1String("searchAgeFrom")].toInt();
-  mAgeTo = cardInfo[QLatin1String("searchAgeTo")].toInt();
-  mSex = sexToUserSex(cardInfo[QLatin1String("sex")].toString());
-  mSearchSex = sexToUserSex(cardInfo[QLatin1String("searchSex")].toString());
+void User::updateCardInfo(const UserCard &cardInfo) {
+  mDescription = cardInfo.mDescription;
+  mAvatarId = cardInfo.mAvatarId;
+  mBirthDate = cardInfo.mBirthDate;
+  mUid = cardInfo.mUid;
+  mLatitude = cardInfo.mLatitude;
+  mLongitude = cardInfo.mLongitude;
+  mToken = cardInfo.mToken;
+  mAgeFrom = cardInfo.mAgeFrom;
+  mAgeTo = cardInfo.mAgeTo;
+  mSex = cardInfo.mSex;
+  mSearchSex = cardInfo.mSearchSex;
 }
 
 } // namespace Czateria
@@ -1,48 +1,67 @@
 #ifndef USER_H
 #define USER_H
 
-class QJsonObject;
-
 #include <QDate>
 #include <QString>
 
 namespace Czateria {
 
+// per-user "card" information, coming from codes 183 and 184.
+struct UserCard {
+  enum class Sex { Male, Female, Both, Unspecified };
+
+  static Sex sexFromString(const QString &sex);
+
+  QString mUserName; // only present in code 184 updates
+  QString mDescription;
+  QString mAvatarId;
+  QDate mBirthDate;
+  int mUid = 0;
+  int mLatitude = 0;
+  int mLongitude = 0;
+  QString mToken;
+  int mAgeFrom = 0;
+  int mAgeTo = 0;
+  Sex mSex = Sex::Unspecified;
+  Sex mSearchSex = Sex::Unspecified;
+};
+
 struct User {
 public:
-  // basicInfo comes from code 132, cardInfo from code 183. those two arrays
+  enum class Type { Guest, Registered, Admin, SuperAdmin, Honoured };
+  using Sex = UserCard::Sex;
+
+  static Type typeFromPerm(int perm);
+
+  User() {}
+  explicit User(const QString &nickname) : mLogin(nickname) {}
+
+  // basic info comes from code 132, card info from code 183. those two arrays
   // are parallel and objects at the same indices form information about the
   // same user. very peculiar if you ask me, especially seeing how later updates
   // of this information come as single objects.
-  User(const QJsonObject &basicInfo, const QJsonObject &cardInfo);
-  explicit User(const QString &nickname) : mLogin(nickname) {}
-  explicit User(const QJsonObject &basicInfo);
-
-  void updateCardInfo(const QJsonObject &cardInfo);
-
-  enum class Type { Guest, Registered, Admin, SuperAdmin, Honoured };
-  enum class Sex { Male, Female, Both, Unspecified };
+  void updateCardInfo(const UserCard &cardInfo);
 
   bool operator<(const User &u2) const {
     return QString::compare(mLogin, u2.mLogin, Qt::CaseInsensitive) < 0;
   }
 
   QString mLogin;
-  int mEmotion;
-  bool mMobileUser;
-  bool mHasPrivs;
-  Type mType;
+  int mEmotion = 0;
+  bool mMobileUser = false;
+  bool mHasPrivs = false;
+  Type mType = Type::Guest;
   QString mDescription;
   QString mAvatarId;
   QDate mBirthDate;
-  int mUid;
-  int mLatitude;
-  int mLongitude;
+  int mUid = 0;
+  int mLatitude = 0;
+  int mLongitude = 0;
   QString mToken;
-  int mAgeFrom;
-  int mAgeTo;
-  Sex mSex;
-  Sex mSearchSex;
+  int mAgeFrom = 0;
+  int mAgeTo = 0;
+  Sex mSex = Sex::Unspecified;
+  Sex mSearchSex = Sex::Unspecified;
 };
 
 } // namespace Czateria
@@ -1,9 +1,10 @@
 #include "userlistmodel.h"
 
 #include <QFont>
-#include <QJsonObject>
 #include <QTextStream>
 
+#include <iterator>
+
 #include "avatarhandler.h"
 #include "chatblocker.h"
 #include "chatsession.h"
@@ -88,41 +89,97 @@ UserListModel::UserListModel(const AvatarHandler &avatars,
           &UserListModel::onBlockerChanged);
 }
 
-void UserListModel::setUserData(const QJsonArray &userData) {
+void UserListModel::setUserData(std::vector<User> &&userData) {
   if (mCardDataCache) {
-    populateUsers(userData, *mCardDataCache);
+    populateUsers(std::move(userData), *mCardDataCache);
   } else {
-    mUserDataCache = std::make_unique<QJsonArray>(userData);
+    mUserDataCache = std::make_unique<std::vector<User>>(std::move(userData));
   }
 }
 
-void UserListModel::setCardData(const QJsonArray &cardData) {
+void UserListModel::setCardData(std::vector<UserCard> &&cardData) {
   if (mUserDataCache) {
-    populateUsers(*mUserDataCache, cardData);
+    populateUsers(std::move(*mUserDataCache), cardData);
   } else {
-    mCardDataCache = std::make_unique<QJsonArray>(cardData);
+    mCardDataCache =
+        std::make_unique<std::vector<UserCard>>(std::move(cardData));
   }
 }
 
-void UserListModel::populateUsers(const QJsonArray &userData,
-                                  const QJsonArray &cardData) {
-  beginResetModel();
-  mUsers.clear();
-
+void UserListModel::populateUsers(std::vector<User> &&userData,
+                                  const std::vector<UserCard> &cardData) {
+  std::vector<User> users;
   // should be equal, but just to be on the safe side.
-  const auto finalIdx = std::min(userData.count(), cardData.count());
-  mUsers.reserve(static_cast<unsigned>(finalIdx));
-  for (int i = 0; i < finalIdx; ++i) {
-    auto usr = User(userData[i].toObject(), cardData[i].toObject());
+  const auto finalIdx = std::min(userData.size(), cardData.size());
+  users.reserve(finalIdx);
+  for (std::size_t i = 0; i < finalIdx; ++i) {
+    auto &&usr = userData[i];
     if (!mBlocker.isUserBlocked(usr.mLogin)) {
-      mUsers.emplace_back(usr);
+      usr.updateCardInfo(cardData[i]);
+      users.emplace_back(std::move(usr));
     }
   }
-
-  std::sort(std::begin(mUsers), std::end(mUsers));
+  std::sort(std::begin(users), std::end(users));
   mUserDataCache.reset();
   mCardDataCache.reset();
-  endResetModel();
+
+  if (mUsers.empty()) {
+    beginResetModel();
+    mUsers = std::move(users);
+    endResetModel();
+  } else {
+    // a snapshot received after reconnecting mostly matches what's already
+    // there. resetting the model would lose the views' selection and scroll
+    // position, so only the differences are applied instead.
+    mergeUsers(std::move(users));
+  }
+  emit snapshotApplied();
+}
+
+void UserListModel::mergeUsers(std::vector<User> &&users) {
+  std::size_t row = 0, src = 0;
+  bool anyKept = false;
+  while (row < mUsers.size() || src < users.size()) {
+    if (src == users.size() ||
+        (row < mUsers.size() && mUsers[row] < users[src])) {
+      auto last = row + 1;
+      while (last < mUsers.size() &&
+             (src == users.size() || mUsers[last] < users[src])) {
+        ++last;
+      }
+      beginRemoveRows(QModelIndex(), static_cast<int>(row),
+                      static_cast<int>(last - 1));
+      mUsers.erase(std::begin(mUsers) + static_cast<std::ptrdiff_t>(row),
+                   std::begin(mUsers) + static_cast<std::ptrdiff_t>(last));
+      endRemoveRows();
+    } else if (row == mUsers.size() || users[src] < mUsers[row]) {
+      auto last = src + 1;
+      while (last < users.size() &&
+             (row == mUsers.size() || users[last] < mUsers[row])) {
+        ++last;
+      }
+      beginInsertRows(QModelIndex(), static_cast<int>(row),
+                      static_cast<int>(row + last - src - 1));
+      mUsers.insert(
+          std::begin(mUsers) + static_cast<std::ptrdiff_t>(row),
+          std::make_move_iterator(std::begin(users) +
+                                  static_cast<std::ptrdiff_t>(src)),
+          std::make_move_iterator(std::begin(users) +
+                                  static_cast<std::ptrdiff_t>(last)));
+      endInsertRows();
+      row += last - src;
+      src = last;
+    } else {
+      mUsers[row++] = std::move(users[src++]);
+      anyKept = true;
+    }
+  }
+  if (anyKept) {
+    // cheaper than tracking every single row which was kept, and views only
+    // care about the visible ones anyway.
+    emit dataChanged(index(0), index(rowCount() - 1),
+                     {Qt::FontRole, Qt::ToolTipRole});
+  }
 }
 
 void UserListModel::onBlockerChanged() {
@@ -145,14 +202,12 @@ UserListModel::removeUserInternal(std::vector<User>::iterator it) {
   return rv;
 }
 
-void UserListModel::updateCardData(const QJsonObject &json) {
-  Q_ASSERT(json[QLatin1String("code")].toInt() == 184);
+void UserListModel::updateCardData(const UserCard &card) {
   const auto itBegin = std::begin(mUsers);
   const auto itEnd = std::end(mUsers);
-  auto it = binary_find(itBegin, itEnd,
-                        User(json[QLatin1String("userName")].toString()));
+  auto it = binary_find(itBegin, itEnd, User(card.mUserName));
   if (it != itEnd) {
-    it->updateCardInfo(json);
+    it->updateCardInfo(card);
     auto row = std::distance(itBegin, it);
     auto modIdx = index(static_cast<int>(row));
     emit dataChanged(modIdx, modIdx, {Qt::ToolTipRole});
@@ -171,9 +226,8 @@ void UserListModel::setPrivStatus(const QString &nickname, bool hasPrivs) {
   }
 }
 
-void UserListModel::addUsers(const QJsonArray &userData) {
-  for (int i = 0; i < userData.size(); ++i) {
-    auto user = User(userData[i].toObject());
+void UserListModel::addUsers(const std::vector<User> &userData) {
+  for (auto &&user : userData) {
     if (user.mLogin == mSession.nickname() ||
         !mBlocker.isUserBlocked(user.mLogin)) {
       auto it = std::upper_bound(std::begin(mUsers), std::end(mUsers), user);
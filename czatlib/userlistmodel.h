@@ -4,12 +4,9 @@
 #include "user.h"
 
 #include <QAbstractListModel>
-#include <QJsonArray>
 
-#include <map>
 #include <memory>
-
-class QJsonObject;
+#include <vector>
 
 namespace Czateria {
 
@@ -23,13 +20,13 @@ public:
   UserListModel(const AvatarHandler &avatars, const ChatBlocker &blocker,
                 ChatSession *parent);
 
-  void setUserData(const QJsonArray &userData);
-  void setCardData(const QJsonArray &cardData);
+  void setUserData(std::vector<User> &&userData);
+  void setCardData(std::vector<UserCard> &&cardData);
 
-  void updateCardData(const QJsonObject &json);
+  void updateCardData(const UserCard &card);
   void setPrivStatus(const QString &nickname, bool hasPrivs);
 
-  void addUsers(const QJsonArray &userData);
+  void addUsers(const std::vector<User> &userData);
   void removeUser(const QString &nickname);
   User *user(const QString &nickname);
 
@@ -37,16 +34,22 @@ public:
   QVariant data(const QModelIndex &index,
                 int role = Qt::DisplayRole) const override;
 
+signals:
+  // both parts of the user list the server sends after joining are in.
+  void snapshotApplied();
+
 private:
-  void populateUsers(const QJsonArray &userData, const QJsonArray &cardData);
+  void populateUsers(std::vector<User> &&userData,
+                     const std::vector<UserCard> &cardData);
+  void mergeUsers(std::vector<User> &&users);
   void onBlockerChanged();
   std::vector<User>::iterator
   removeUserInternal(std::vector<User>::iterator it);
 
   std::vector<User> mUsers;
 
-  std::unique_ptr<QJsonArray> mUserDataCache;
-  std::unique_ptr<QJsonArray> mCardDataCache;
+  std::unique_ptr<std::vector<User>> mUserDataCache;
+  std::unique_ptr<std::vector<UserCard>> mCardDataCache;
 
   const ChatSession &mSession;
   const AvatarHandler &mAvatarHandler;
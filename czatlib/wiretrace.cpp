@@ -0,0 +1,203 @@
+#include "wiretrace.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+QMutex liveTracesMutex;
+
+QSet<Czateria::WireTrace *> &liveTraces() {
+  static QSet<Czateria::WireTrace *> traces;
+  return traces;
+}
+
+QString &dumpDirectoryStorage() {
+  static QString directory;
+  return directory;
+}
+} // namespace
+
+namespace Czateria {
+
+constexpr int WireTrace::defaultCapacity;
+constexpr int WireTrace::maxRecordSize;
+
+WireTrace::WireTrace(int capacity)
+    : mCapacity(capacity), mStartedAt(QDateTime::currentDateTime()) {
+  mClock.start();
+  QMutexLocker lock(&liveTracesMutex);
+  liveTraces().insert(this);
+}
+
+WireTrace::~WireTrace() {
+  QMutexLocker lock(&liveTracesMutex);
+  liveTraces().remove(this);
+}
+
+void WireTrace::setLabel(const QString &label) {
+  QMutexLocker lock(&mMutex);
+  mLabel = label;
+}
+
+QString WireTrace::label() const {
+  QMutexLocker lock(&mMutex);
+  return mLabel;
+}
+
+void WireTrace::record(Direction direction, const QString &frame) {
+  record(direction, Encoding::Utf16,
+         reinterpret_cast<const char *>(frame.constData()),
+         frame.size() * static_cast<int>(sizeof(QChar)));
+}
+
+void WireTrace::record(Direction direction, const QByteArray &frame) {
+  record(direction, Encoding::Utf8, frame.constData(), frame.size());
+}
+
+void WireTrace::record(Direction direction, Encoding encoding,
+                       const char *data, int size) {
+  auto stored = std::min(size, maxRecordSize);
+  if (encoding == Encoding::Utf16) {
+    stored &= ~1; // don't split code units
+  }
+  const auto total = static_cast<int>(sizeof(RecordHeader)) + stored;
+  if (total > mCapacity) {
+    return;
+  }
+  QMutexLocker lock(&mMutex);
+  if (mBuffer.isEmpty()) {
+    // allocated on first use, as plenty of sessions never get that far.
+    mBuffer.resize(mCapacity);
+  }
+  while (mCapacity - mUsed < total) {
+    evictOldest();
+  }
+  RecordHeader header;
+  header.timestamp = mClock.nsecsElapsed();
+  header.size = static_cast<quint32>(stored);
+  header.originalSize = static_cast<quint32>(size);
+  header.direction = direction;
+  header.encoding = encoding;
+  put(&header, sizeof(header));
+  put(data, stored);
+  mUsed += total;
+  ++mCount;
+}
+
+void WireTrace::put(const void *data, int size) {
+  auto src = static_cast<const char *>(data);
+  const auto first = std::min(size, mCapacity - mHead);
+  std::memcpy(mBuffer.data() + mHead, src, static_cast<std::size_t>(first));
+  std::memcpy(mBuffer.data(), src + first,
+              static_cast<std::size_t>(size - first));
+  mHead = (mHead + size) % mCapacity;
+}
+
+void WireTrace::get(int pos, void *out, int size) const {
+  auto dst = static_cast<char *>(out);
+  const auto first = std::min(size, mCapacity - pos);
+  std::memcpy(dst, mBuffer.constData() + pos, static_cast<std::size_t>(first));
+  std::memcpy(dst + first, mBuffer.constData(),
+              static_cast<std::size_t>(size - first));
+}
+
+void WireTrace::evictOldest() {
+  Q_ASSERT(mCount > 0);
+  RecordHeader header;
+  get(mTail, &header, sizeof(header));
+  const auto total =
+      static_cast<int>(sizeof(RecordHeader)) + static_cast<int>(header.size);
+  mTail = (mTail + total) % mCapacity;
+  mUsed -= total;
+  --mCount;
+}
+
+bool WireTrace::dump(QIODevice *out) const {
+  QMutexLocker lock(&mMutex);
+  out->write(QString(QLatin1String("# %1 : %2 frames, started at %3\n"))
+                 .arg(mLabel)
+                 .arg(mCount)
+                 .arg(mStartedAt.toString(Qt::ISODate))
+                 .toUtf8());
+  auto pos = mTail;
+  QByteArray payload;
+  for (int i = 0; i < mCount; ++i) {
+    RecordHeader header;
+    get(pos, &header, sizeof(header));
+    pos = (pos + static_cast<int>(sizeof(header))) % mCapacity;
+    payload.resize(static_cast<int>(header.size));
+    get(pos, payload.data(), payload.size());
+    pos = (pos + payload.size()) % mCapacity;
+
+    const auto msecs = header.timestamp / 1000000;
+    QByteArray line =
+        mStartedAt.addMSecs(msecs)
+            .toString(QLatin1String("yyyy-MM-dd HH:mm:ss.zzz"))
+            .toLatin1();
+    line.append(header.direction == Direction::Inbound ? " < " : " > ");
+    if (header.encoding == Encoding::Utf16) {
+      line.append(QString(reinterpret_cast<const QChar *>(payload.constData()),
+                          payload.size() / static_cast<int>(sizeof(QChar)))
+                      .toUtf8());
+    } else {
+      line.append(payload);
+    }
+    if (header.originalSize != header.size) {
+      line.append(QString(QLatin1String(" [truncated, %1 bytes total]"))
+                      .arg(header.originalSize)
+                      .toLatin1());
+    }
+    line.append('\n');
+    if (out->write(line) != line.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+QString WireTrace::dumpToDirectory(const QString &directory) const {
+  static const QRegularExpression unsafeChars(QLatin1String("[^\\w.@-]"));
+  auto name = label();
+  name.replace(unsafeChars, QLatin1String("_"));
+  QDir().mkpath(directory);
+  const auto path =
+      QString(QLatin1String("%1/trace-%2-%3.log"))
+          .arg(directory, name,
+               QDateTime::currentDateTime().toString(
+                   QLatin1String("yyyyMMdd-HHmmss-zzz")));
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly) || !dump(&f)) {
+    qInfo() << "Could not write wire trace to" << path;
+    return QString();
+  }
+  return path;
+}
+
+void WireTrace::setDumpDirectory(const QString &directory) {
+  dumpDirectoryStorage() = directory;
+}
+
+const QString &WireTrace::dumpDirectory() { return dumpDirectoryStorage(); }
+
+void WireTrace::dumpAll() {
+  const auto &directory = dumpDirectory();
+  if (directory.isEmpty()) {
+    return;
+  }
+  QMutexLocker lock(&liveTracesMutex);
+  for (auto trace : liveTraces()) {
+    auto path = trace->dumpToDirectory(directory);
+    if (!path.isNull()) {
+      qInfo() << "Wire trace written to" << path;
+    }
+  }
+}
+
+} // namespace Czateria
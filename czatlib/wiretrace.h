@@ -0,0 +1,82 @@
+#ifndef WIRETRACE_H
+#define WIRETRACE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+class QIODevice;
+
+namespace Czateria {
+
+/* a flight recorder for the frames going through a session's socket. frames
+ * are copied verbatim, along with a monotonic timestamp and their direction,
+ * into a fixed-size ring buffer, dropping the oldest ones when it runs out of
+ * space. nothing is formatted until the contents are actually dumped, so
+ * keeping this enabled all the time costs little more than a memcpy per
+ * frame.
+ * sessions may run on worker threads, while dumps are requested from the GUI
+ * thread, hence the lock. it's hardly ever contended. */
+class WireTrace {
+public:
+  enum class Direction : quint8 { Inbound, Outbound };
+
+  static constexpr int defaultCapacity = 128 * 1024;
+  // frames longer than this, i.e. mostly images, are truncated.
+  static constexpr int maxRecordSize = 4 * 1024;
+
+  explicit WireTrace(int capacity = defaultCapacity);
+  ~WireTrace();
+  WireTrace(const WireTrace &) = delete;
+  WireTrace &operator=(const WireTrace &) = delete;
+
+  void setLabel(const QString &label);
+  QString label() const;
+
+  void record(Direction direction, const QString &frame);
+  void record(Direction direction, const QByteArray &frame);
+
+  bool dump(QIODevice *out) const;
+  // writes the trace to a new, uniquely named file in the given directory and
+  // returns its path, or a null string on failure.
+  QString dumpToDirectory(const QString &directory) const;
+
+  // used as the destination of dumps which aren't requested explicitly, e.g.
+  // on session errors.
+  static void setDumpDirectory(const QString &directory);
+  static const QString &dumpDirectory();
+  static void dumpAll();
+
+private:
+  enum class Encoding : quint8 { Utf16, Utf8 };
+  struct RecordHeader {
+    qint64 timestamp;
+    quint32 size;
+    quint32 originalSize;
+    Direction direction;
+    Encoding encoding;
+  };
+
+  void record(Direction direction, Encoding encoding, const char *data,
+              int size);
+  void put(const void *data, int size);
+  void get(int pos, void *out, int size) const;
+  void evictOldest();
+
+  QByteArray mBuffer;
+  const int mCapacity;
+  int mHead = 0;
+  int mTail = 0;
+  int mUsed = 0;
+  int mCount = 0;
+  QElapsedTimer mClock;
+  const QDateTime mStartedAt;
+  QString mLabel;
+  mutable QMutex mMutex;
+};
+
+} // namespace Czateria
+
+#endif // WIRETRACE_H
@@ -0,0 +1,366 @@
+#include "chatserver.h"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QWebSocket>
+
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr int tickInterval = 20;
+constexpr int firstRoomPort = 5001;
+
+QByteArray makeImage(int size) {
+  QImage image(size, size, QImage::Format_RGB32);
+  for (int y = 0; y < size; ++y) {
+    auto line = reinterpret_cast<QRgb *>(image.scanLine(y));
+    for (int x = 0; x < size; ++x) {
+      line[x] = qRgb(x * 255 / size, y * 255 / size, 128);
+    }
+  }
+  QByteArray data;
+  QBuffer buf(&data);
+  buf.open(QIODevice::WriteOnly);
+  image.save(&buf, "JPG");
+  return data.toBase64();
+}
+
+QString toText(const QJsonObject &frame) {
+  return QString::fromUtf8(
+      QJsonDocument(frame).toJson(QJsonDocument::Compact));
+}
+} // namespace
+
+ChatServer::ChatServer(const MockConfig &config, QObject *parent)
+    : QObject(parent), mConfig(config),
+      mServer(QLatin1String("czateria-mock"), QWebSocketServer::NonSecureMode),
+      mRandom(config.seed) {
+  mRooms.resize(static_cast<std::size_t>(mConfig.rooms));
+  for (std::size_t i = 0; i < mRooms.size(); ++i) {
+    auto &room = mRooms[i];
+    room.name =
+        QString(QLatin1String("Room %1")).arg(static_cast<int>(i) + 1);
+    room.port = QString::number(firstRoomPort + static_cast<int>(i));
+    for (; room.nextUserId < mConfig.usersPerRoom; ++room.nextUserId) {
+      room.users.push_back(
+          QString(QLatin1String("user_%1")).arg(room.nextUserId));
+    }
+  }
+  if (mConfig.imageRate > 0) {
+    mImageBase64 = makeImage(mConfig.imageSize);
+  }
+  connect(&mServer, &QWebSocketServer::newConnection, this,
+          &ChatServer::onNewConnection);
+  connect(&mTicker, &QTimer::timeout, this, &ChatServer::tick);
+  mClock.start();
+  mTicker.start(tickInterval);
+}
+
+ChatServer::~ChatServer() = default;
+
+bool ChatServer::listen(quint16 port) {
+  return mServer.listen(QHostAddress::Any, port);
+}
+
+QByteArray ChatServer::roomListJson() const {
+  QJsonArray rooms;
+  for (std::size_t i = 0; i < mRooms.size(); ++i) {
+    auto &&room = mRooms[i];
+    QJsonObject obj;
+    obj[QLatin1String("id")] = static_cast<int>(i + 1);
+    obj[QLatin1String("name")] = room.name;
+    obj[QLatin1String("serverPort")] = room.port;
+    obj[QLatin1String("usersCount")] = QString::number(
+        static_cast<int>(room.users.size() + room.clients.size()));
+    rooms.append(obj);
+  }
+  QJsonObject group;
+  group[QLatin1String("rooms")] = rooms;
+  return QJsonDocument(QJsonArray{group}).toJson(QJsonDocument::Compact);
+}
+
+void ChatServer::onNewConnection() {
+  while (auto socket = mServer.nextPendingConnection()) {
+    mClients.push_back(std::make_unique<Client>());
+    auto client = mClients.back().get();
+    client->socket = socket;
+    client->lastKeepalive = mClock.elapsed();
+    connect(socket, &QWebSocket::textMessageReceived, this,
+            [=](const QString &text) { onTextMessage(client, text); });
+    connect(socket, &QWebSocket::disconnected, this,
+            [=]() { onDisconnected(client); });
+    send(*client, QJsonObject{{QLatin1String("code"), 138}});
+  }
+}
+
+void ChatServer::onDisconnected(Client *client) {
+  if (auto room = client->room) {
+    room->clients.erase(
+        std::remove(std::begin(room->clients), std::end(room->clients), client),
+        std::end(room->clients));
+    broadcast(*room, QJsonObject{{QLatin1String("code"), 130},
+                                 {QLatin1String("login"), client->nickname}});
+  }
+  client->socket->deleteLater();
+  mClients.erase(std::find_if(std::begin(mClients), std::end(mClients),
+                              [=](auto &&c) { return c.get() == client; }));
+}
+
+void ChatServer::onTextMessage(Client *client, const QString &text) {
+  auto frame = QJsonDocument::fromJson(text.toUtf8()).object();
+  const auto code = frame[QLatin1String("code")].toInt();
+  switch (code) {
+  case 108:
+    onLogin(client, frame);
+    break;
+  case 1:
+    if (client->room) {
+      const QJsonObject message{
+          {QLatin1String("code"), 129},
+          {QLatin1String("login"), client->nickname},
+          {QLatin1String("msg"), frame[QLatin1String("msg")]}};
+      broadcast(*client->room, message, client);
+    }
+    break;
+  case 97:
+    onPrivateMessage(client, frame);
+    break;
+  case 80:
+    client->socket->close();
+    break;
+  case 1003:
+    break;
+  default:
+    qInfo() << "Unknown frame received :" << text;
+    break;
+  }
+}
+
+void ChatServer::onLogin(Client *client, const QJsonObject &frame) {
+  const auto channel = frame[QLatin1String("channelName")].toString();
+  auto it = std::find_if(std::begin(mRooms), std::end(mRooms),
+                         [&](auto &&room) { return room.name == channel; });
+  if (it == std::end(mRooms) || client->room) {
+    send(*client, QJsonObject{{QLatin1String("code"), 150},
+                              {QLatin1String("subcode"), 1}});
+    return;
+  }
+  auto &room = *it;
+  client->nickname = frame[QLatin1String("login")].toString();
+  if (client->nickname.isEmpty()) {
+    client->nickname = QString::fromUtf8("go\xc5\x9b\xc4\x87_%1")
+                           .arg(mNextGuestId++, 8, 10, QLatin1Char('0'));
+  }
+  send(*client, QJsonObject{{QLatin1String("code"), 200},
+                            {QLatin1String("username"), client->nickname}});
+
+  QJsonArray users, cards;
+  for (auto &&nickname : room.users) {
+    users.append(userObject(nickname));
+    cards.append(cardObject(nickname));
+  }
+  for (auto &&other : room.clients) {
+    users.append(userObject(other->nickname));
+    cards.append(cardObject(other->nickname));
+  }
+  users.append(userObject(client->nickname));
+  cards.append(cardObject(client->nickname));
+  send(*client, QJsonObject{{QLatin1String("code"), 132},
+                            {QLatin1String("users"), users}});
+  send(*client, QJsonObject{{QLatin1String("code"), 183},
+                            {QLatin1String("cards"), cards}});
+
+  broadcast(room, QJsonObject{{QLatin1String("code"), 128},
+                              {QLatin1String("users"),
+                               QJsonArray{userObject(client->nickname)}}});
+  room.clients.push_back(client);
+  client->room = &room;
+}
+
+void ChatServer::onPrivateMessage(Client *client, const QJsonObject &frame) {
+  if (!client->room) {
+    return;
+  }
+  const auto target = frame[QLatin1String("user")].toString();
+  const auto subcode = frame[QLatin1String("subcode")].toInt();
+  if (auto other = findClient(*client->room, target)) {
+    auto relayed = frame;
+    relayed[QLatin1String("user")] = client->nickname;
+    send(*other, relayed);
+    if (subcode == 25) {
+      send(*client, QJsonObject{{QLatin1String("code"), 97},
+                                {QLatin1String("subcode"), 26},
+                                {QLatin1String("user"), target}});
+    }
+    return;
+  }
+
+  // simulated users are very polite, and answer everything right away.
+  switch (subcode) {
+  case 1:
+  case 2:
+    send(*client, QJsonObject{{QLatin1String("code"), 97},
+                              {QLatin1String("subcode"), 2},
+                              {QLatin1String("user"), target},
+                              {QLatin1String("msg"), randomMessage()}});
+    break;
+  case 25:
+    send(*client, QJsonObject{{QLatin1String("code"), 97},
+                              {QLatin1String("subcode"), 26},
+                              {QLatin1String("user"), target}});
+    break;
+  }
+}
+
+void ChatServer::tick() {
+  const auto now = mClock.elapsed();
+  const auto seconds = (now - mLastTick) / 1000.0;
+  mLastTick = now;
+  for (auto &&room : mRooms) {
+    simulateRoom(room, seconds);
+  }
+  for (auto &&client : mClients) {
+    simulateClient(*client, seconds, now);
+  }
+}
+
+void ChatServer::simulateRoom(SimRoom &room, double seconds) {
+  room.pendingMessages += mConfig.messageRate * seconds;
+  for (; room.pendingMessages >= 1; room.pendingMessages -= 1) {
+    if (room.users.empty()) {
+      continue;
+    }
+    broadcast(room, QJsonObject{{QLatin1String("code"), 129},
+                                {QLatin1String("login"), randomUser(room)},
+                                {QLatin1String("msg"), randomMessage()}});
+  }
+
+  room.pendingJoins += mConfig.joinRate * seconds;
+  for (; room.pendingJoins >= 1; room.pendingJoins -= 1) {
+    // keep the population around the configured size.
+    const auto join =
+        room.users.size() < static_cast<std::size_t>(mConfig.usersPerRoom) ||
+        (mRandom() & 1);
+    if (join) {
+      auto nickname = QString(QLatin1String("user_%1")).arg(room.nextUserId++);
+      room.users.push_back(nickname);
+      broadcast(room, QJsonObject{{QLatin1String("code"), 128},
+                                  {QLatin1String("users"),
+                                   QJsonArray{userObject(nickname)}}});
+      auto card = cardObject(nickname);
+      card[QLatin1String("code")] = 184;
+      broadcast(room, card);
+    } else {
+      std::uniform_int_distribution<std::ptrdiff_t> dist(
+          0, static_cast<std::ptrdiff_t>(room.users.size()) - 1);
+      auto it = std::begin(room.users) + dist(mRandom);
+      broadcast(room, QJsonObject{{QLatin1String("code"), 130},
+                                  {QLatin1String("login"), *it}});
+      room.users.erase(it);
+    }
+  }
+}
+
+void ChatServer::simulateClient(Client &client, double seconds, qint64 now) {
+  if (!client.room) {
+    return;
+  }
+  if (now - client.lastKeepalive >= mConfig.keepaliveInterval * 1000ll) {
+    client.lastKeepalive = now;
+    send(client, QJsonObject{{QLatin1String("code"), 1003}});
+  }
+  if (client.room->users.empty()) {
+    return;
+  }
+
+  client.pendingPrivs += mConfig.privRate * seconds;
+  for (; client.pendingPrivs >= 1; client.pendingPrivs -= 1) {
+    send(client, QJsonObject{{QLatin1String("code"), 97},
+                             {QLatin1String("subcode"), 1},
+                             {QLatin1String("user"), randomUser(*client.room)},
+                             {QLatin1String("msg"), randomMessage()}});
+  }
+
+  client.pendingImages += mConfig.imageRate * seconds;
+  for (; client.pendingImages >= 1; client.pendingImages -= 1) {
+    // the image is several times bigger than the rest of the frame, so there's
+    // no point in going through QJsonDocument just to copy it around.
+    QByteArray frame("{\"code\":97,\"subcode\":25,\"type\":1,\"user\":\"");
+    frame.append(randomUser(*client.room).toUtf8());
+    frame.append("\",\"imgWidth\":");
+    frame.append(QByteArray::number(mConfig.imageSize));
+    frame.append(",\"imgHeight\":");
+    frame.append(QByteArray::number(mConfig.imageSize));
+    frame.append(",\"data\":\"");
+    frame.append(mImageBase64);
+    frame.append("\"}");
+    client.socket->sendTextMessage(QString::fromUtf8(frame));
+  }
+}
+
+void ChatServer::send(Client &client, const QJsonObject &frame) {
+  client.socket->sendTextMessage(toText(frame));
+}
+
+void ChatServer::broadcast(SimRoom &room, const QJsonObject &frame,
+                           const Client *except) {
+  if (room.clients.empty()) {
+    return;
+  }
+  const auto text = toText(frame);
+  for (auto &&client : room.clients) {
+    if (client != except) {
+      client->socket->sendTextMessage(text);
+    }
+  }
+}
+
+QJsonObject ChatServer::userObject(const QString &nickname) const {
+  return QJsonObject{{QLatin1String("login"), nickname},
+                     {QLatin1String("emotion"), 0},
+                     {QLatin1String("isMobileUser"), false},
+                     {QLatin1String("privs"), 1},
+                     {QLatin1String("perm"), 0}};
+}
+
+QJsonObject ChatServer::cardObject(const QString &nickname) const {
+  // the avatar is left empty so that the client doesn't go looking for it on
+  // the real servers.
+  return QJsonObject{{QLatin1String("userName"), nickname},
+                     {QLatin1String("description"), QLatin1String("mock")},
+                     {QLatin1String("avatarId"), QString()},
+                     {QLatin1String("bornDate"), QLatin1String("01-01-1990")},
+                     {QLatin1String("uid"), nickname},
+                     {QLatin1String("lat"), 0},
+                     {QLatin1String("lon"), 0},
+                     {QLatin1String("sex"), QLatin1String("M")},
+                     {QLatin1String("searchSex"), QLatin1String("B")}};
+}
+
+QString ChatServer::randomUser(const SimRoom &room) {
+  std::uniform_int_distribution<std::size_t> dist(0, room.users.size() - 1);
+  return room.users[dist(mRandom)];
+}
+
+QString ChatServer::randomMessage() {
+  static const std::array<QString, 4> messages = {
+      {QLatin1String("hello"),
+       QString::fromUtf8("za\xc5\xbc\xc3\xb3\xc5\x82\xc4\x87 "
+                         "g\xc4\x99\xc5\x9bl\xc4\x85 ja\xc5\xba\xc5\x84"),
+       QLatin1String("<a href=\"https://example.com\">link</a> :)"),
+       QLatin1String("a somewhat longer message, the kind that tends to wrap "
+                     "in the chat window if it's narrow enough")}};
+  std::uniform_int_distribution<std::size_t> dist(0, messages.size() - 1);
+  return messages[dist(mRandom)];
+}
+
+ChatServer::Client *ChatServer::findClient(const SimRoom &room,
+                                           const QString &nickname) const {
+  auto it = std::find_if(std::begin(room.clients), std::end(room.clients),
+                         [&](auto &&c) { return c->nickname == nickname; });
+  return it != std::end(room.clients) ? *it : nullptr;
+}
@@ -0,0 +1,98 @@
+#ifndef CHATSERVER_H
+#define CHATSERVER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QWebSocketServer>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+class QWebSocket;
+
+struct MockConfig {
+  int rooms = 3;
+  int usersPerRoom = 500;
+  // all the rates are in events per second. room messages, joins and parts
+  // are per room, private messages and images per connected client.
+  double messageRate = 5;
+  double joinRate = 1;
+  double privRate = 0.1;
+  double imageRate = 0;
+  // edge of the images sent, in pixels.
+  int imageSize = 300;
+  // in seconds, like the real thing.
+  int keepaliveInterval = 240;
+  unsigned seed = 0;
+};
+
+/* pretends to be the chat server, filling each room with simulated users who
+ * talk, come and go, and write to the connected clients in private. whatever
+ * the clients send to each other is relayed as well, so several clients can
+ * talk to each other through it. */
+class ChatServer : public QObject {
+  Q_OBJECT
+public:
+  explicit ChatServer(const MockConfig &config, QObject *parent = nullptr);
+  ~ChatServer() override;
+
+  bool listen(quint16 port);
+  // the reply to /rooms-list.
+  QByteArray roomListJson() const;
+
+private:
+  struct Client;
+  struct SimRoom {
+    QString name;
+    QString port;
+    std::vector<QString> users;
+    std::vector<Client *> clients;
+    int nextUserId = 0;
+    double pendingMessages = 0;
+    double pendingJoins = 0;
+  };
+  struct Client {
+    QWebSocket *socket;
+    QString nickname;
+    SimRoom *room = nullptr;
+    double pendingPrivs = 0;
+    double pendingImages = 0;
+    qint64 lastKeepalive = 0;
+  };
+
+  void onNewConnection();
+  void onDisconnected(Client *client);
+  void onTextMessage(Client *client, const QString &text);
+  void onLogin(Client *client, const QJsonObject &frame);
+  void onPrivateMessage(Client *client, const QJsonObject &frame);
+  void tick();
+  void simulateRoom(SimRoom &room, double seconds);
+  void simulateClient(Client &client, double seconds, qint64 now);
+
+  void send(Client &client, const QJsonObject &frame);
+  void broadcast(SimRoom &room, const QJsonObject &frame,
+                 const Client *except = nullptr);
+  QJsonObject userObject(const QString &nickname) const;
+  QJsonObject cardObject(const QString &nickname) const;
+  QString randomUser(const SimRoom &room);
+  QString randomMessage();
+  Client *findClient(const SimRoom &room, const QString &nickname) const;
+
+  const MockConfig mConfig;
+  QWebSocketServer mServer;
+  std::vector<SimRoom> mRooms;
+  std::vector<std::unique_ptr<Client>> mClients;
+  QByteArray mImageBase64;
+  std::mt19937 mRandom;
+  QTimer mTicker;
+  QElapsedTimer mClock;
+  qint64 mLastTick = 0;
+  int mNextGuestId = 0;
+};
+
+#endif // CHATSERVER_H
@@ -0,0 +1,126 @@
+#include "httpresponder.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include "chatserver.h"
+
+namespace {
+// requests from the client are tiny. anything bigger than this isn't coming
+// from it.
+constexpr int maxRequestSize = 64 * 1024;
+
+QByteArray headerValue(const QByteArray &headers, const QByteArray &name) {
+  for (auto &&line : headers.split('\n')) {
+    const auto colon = line.indexOf(':');
+    if (colon > 0 && line.left(colon).trimmed().toLower() == name) {
+      return line.mid(colon + 1).trimmed();
+    }
+  }
+  return QByteArray();
+}
+
+QByteArray statusText(int status) {
+  switch (status) {
+  case 200:
+    return "OK";
+  case 400:
+    return "Bad Request";
+  case 404:
+    return "Not Found";
+  }
+  return "Error";
+}
+} // namespace
+
+HttpResponder::HttpResponder(const ChatServer &chatServer, QObject *parent)
+    : QObject(parent), mChatServer(chatServer) {
+  QImage captcha(120, 40, QImage::Format_RGB32);
+  captcha.fill(Qt::lightGray);
+  QBuffer buf(&mCaptchaImage);
+  buf.open(QIODevice::WriteOnly);
+  captcha.save(&buf, "PNG");
+  connect(&mServer, &QTcpServer::newConnection, this,
+          &HttpResponder::onNewConnection);
+}
+
+bool HttpResponder::listen(quint16 port) {
+  return mServer.listen(QHostAddress::Any, port);
+}
+
+void HttpResponder::onNewConnection() {
+  while (auto socket = mServer.nextPendingConnection()) {
+    connect(socket, &QTcpSocket::readyRead, this,
+            [=]() { onReadyRead(socket); });
+    connect(socket, &QTcpSocket::disconnected, this, [=]() {
+      mPending.remove(socket);
+      socket->deleteLater();
+    });
+  }
+}
+
+void HttpResponder::onReadyRead(QTcpSocket *socket) {
+  auto &request = mPending[socket];
+  request.append(socket->readAll());
+  if (request.size() > maxRequestSize) {
+    reply(socket, "text/plain", "request too large", 400);
+    return;
+  }
+  const auto headersEnd = request.indexOf("\r\n\r\n");
+  if (headersEnd < 0) {
+    return;
+  }
+  const auto headers = request.left(headersEnd);
+  const auto bodySize = headerValue(headers, "content-length").toInt();
+  if (request.size() < headersEnd + 4 + bodySize) {
+    return;
+  }
+  const auto requestLine = headers.left(headers.indexOf("\r\n")).split(' ');
+  if (requestLine.size() != 3) {
+    reply(socket, "text/plain", "malformed request", 400);
+    return;
+  }
+  respond(socket, requestLine[0], requestLine[1],
+          headerValue(headers, "host"));
+}
+
+void HttpResponder::respond(QTcpSocket *socket, const QByteArray &method,
+                            const QByteArray &target, const QByteArray &host) {
+  const QUrl url(QString::fromLatin1(target));
+  const auto path = url.path();
+  if (method == "GET" && path == QLatin1String("/rooms-list")) {
+    reply(socket, "application/json", mChatServer.roomListJson());
+  } else if (method == "POST" &&
+             (path == QLatin1String("/scp/user/login") ||
+              path == QLatin1String("/scp/user/guest"))) {
+    // any credentials and any captcha response are good enough.
+    reply(socket, "application/json",
+          "{\"code\":1,\"msg\":\"OK\",\"status\":1,\"data\":{\"0\":\"mock-" +
+              QByteArray::number(mNextSessionId++) + "\"}}");
+  } else if (method == "GET" && path == QLatin1String("/captcha/getEnigmaJS")) {
+    const auto callback =
+        QUrlQuery(url).queryItemValue(QLatin1String("callback")).toLatin1();
+    reply(socket, "application/javascript",
+          callback + "({uid:\"mock\",url:\"http://" + host +
+              "/captcha/image.png\"})");
+  } else if (method == "GET" && path == QLatin1String("/captcha/image.png")) {
+    reply(socket, "image/png", mCaptchaImage);
+  } else {
+    reply(socket, "text/plain", "not found", 404);
+  }
+}
+
+void HttpResponder::reply(QTcpSocket *socket, const QByteArray &contentType,
+                          const QByteArray &body, int status) {
+  QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' +
+                        statusText(status) + "\r\nContent-Type: " +
+                        contentType + "\r\nContent-Length: " +
+                        QByteArray::number(body.size()) +
+                        "\r\nConnection: close\r\n\r\n" + body;
+  socket->write(response);
+  socket->disconnectFromHost();
+  mPending.remove(socket);
+}
@@ -0,0 +1,36 @@
+#ifndef HTTPRESPONDER_H
+#define HTTPRESPONDER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QTcpServer>
+
+class ChatServer;
+class QTcpSocket;
+
+/* just enough of an HTTP server to handle the requests made by the client
+ * before it connects to the chat server : the room list, logging in, and
+ * captchas. every reply closes the connection. */
+class HttpResponder : public QObject {
+  Q_OBJECT
+public:
+  HttpResponder(const ChatServer &chatServer, QObject *parent = nullptr);
+
+  bool listen(quint16 port);
+
+private:
+  void onNewConnection();
+  void onReadyRead(QTcpSocket *socket);
+  void respond(QTcpSocket *socket, const QByteArray &method,
+               const QByteArray &target, const QByteArray &host);
+  void reply(QTcpSocket *socket, const QByteArray &contentType,
+             const QByteArray &body, int status = 200);
+
+  const ChatServer &mChatServer;
+  QTcpServer mServer;
+  QHash<QTcpSocket *, QByteArray> mPending;
+  QByteArray mCaptchaImage;
+  int mNextSessionId = 0;
+};
+
+#endif // HTTPRESPONDER_H
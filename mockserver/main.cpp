@@ -0,0 +1,118 @@
+#include "chatserver.h"
+#include "httpresponder.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTextStream>
+
+#include <type_traits>
+
+namespace {
+template <typename T>
+bool readOption(const QCommandLineParser &parser,
+                const QCommandLineOption &option, T &out) {
+  if (!parser.isSet(option)) {
+    return true;
+  }
+  bool ok;
+  const auto value = parser.value(option);
+  if (std::is_floating_point<T>::value) {
+    const auto v = value.toDouble(&ok);
+    ok = ok && v >= 0;
+    out = static_cast<T>(v);
+  } else {
+    const auto v = value.toLongLong(&ok);
+    ok = ok && v >= 0;
+    out = static_cast<T>(v);
+  }
+  if (!ok) {
+    qCritical().noquote() << "Invalid value for" << option.names().first()
+                          << ":" << value;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  QCoreApplication::setApplicationName(QLatin1String("czateria-mockserver"));
+  QCoreApplication a(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      QLatin1String("A stand-in for the Czateria servers, meant for testing "
+                    "the client offline."));
+  parser.addHelpOption();
+  // clang-format off
+  QCommandLineOption httpPortOption(QLatin1String("http-port"),
+      QLatin1String("Port serving the room list and the login API."),
+      QLatin1String("port"), QLatin1String("8080"));
+  QCommandLineOption wsPortOption(QLatin1String("ws-port"),
+      QLatin1String("Port of the chat server."),
+      QLatin1String("port"), QLatin1String("8081"));
+  QCommandLineOption roomsOption(QLatin1String("rooms"),
+      QLatin1String("Number of rooms."), QLatin1String("count"));
+  QCommandLineOption usersOption(QLatin1String("users"),
+      QLatin1String("Simulated users per room."), QLatin1String("count"));
+  QCommandLineOption messageRateOption(QLatin1String("message-rate"),
+      QLatin1String("Room messages per second, per room."),
+      QLatin1String("rate"));
+  QCommandLineOption joinRateOption(QLatin1String("join-rate"),
+      QLatin1String("Joins and parts per second, per room."),
+      QLatin1String("rate"));
+  QCommandLineOption privRateOption(QLatin1String("priv-rate"),
+      QLatin1String("Private messages per second, per client."),
+      QLatin1String("rate"));
+  QCommandLineOption imageRateOption(QLatin1String("image-rate"),
+      QLatin1String("Images per second, per client."), QLatin1String("rate"));
+  QCommandLineOption imageSizeOption(QLatin1String("image-size"),
+      QLatin1String("Width and height of the images, in pixels."),
+      QLatin1String("pixels"));
+  QCommandLineOption keepaliveOption(QLatin1String("keepalive"),
+      QLatin1String("Keepalive request interval, in seconds."),
+      QLatin1String("seconds"));
+  QCommandLineOption seedOption(QLatin1String("seed"),
+      QLatin1String("Random number generator seed."), QLatin1String("seed"));
+  // clang-format on
+  parser.addOptions({httpPortOption, wsPortOption, roomsOption, usersOption,
+                     messageRateOption, joinRateOption, privRateOption,
+                     imageRateOption, imageSizeOption, keepaliveOption,
+                     seedOption});
+  parser.process(a);
+
+  MockConfig config;
+  quint16 httpPort = 0, wsPort = 0;
+  if (!readOption(parser, httpPortOption, httpPort) ||
+      !readOption(parser, wsPortOption, wsPort) ||
+      !readOption(parser, roomsOption, config.rooms) ||
+      !readOption(parser, usersOption, config.usersPerRoom) ||
+      !readOption(parser, messageRateOption, config.messageRate) ||
+      !readOption(parser, joinRateOption, config.joinRate) ||
+      !readOption(parser, privRateOption, config.privRate) ||
+      !readOption(parser, imageRateOption, config.imageRate) ||
+      !readOption(parser, imageSizeOption, config.imageSize) ||
+      !readOption(parser, keepaliveOption, config.keepaliveInterval) ||
+      !readOption(parser, seedOption, config.seed)) {
+    return 1;
+  }
+
+  ChatServer chatServer(config);
+  if (!chatServer.listen(wsPort)) {
+    qCritical() << "Could not listen on port" << wsPort;
+    return 1;
+  }
+  HttpResponder http(chatServer);
+  if (!http.listen(httpPort)) {
+    qCritical() << "Could not listen on port" << httpPort;
+    return 1;
+  }
+
+  QTextStream out(stdout);
+  out << "Point the client at this server with :\n"
+      << "CZATERIA_WWW_URL=http://127.0.0.1:" << httpPort << '\n'
+      << "CZATERIA_API_URL=http://127.0.0.1:" << httpPort << '\n'
+      << "CZATERIA_WS_URL=ws://127.0.0.1:" << wsPort << "/%1\n";
+  out.flush();
+  return a.exec();
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+TARGET = czateria-mockserver
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../czateria.pri)
+
+QT += core gui network websockets
+
+SOURCES += \
+    chatserver.cpp \
+    httpresponder.cpp \
+    main.cpp
+
+HEADERS += \
+    chatserver.h \
+    httpresponder.h
@@ -0,0 +1,217 @@
+#include "appsettings.h"
+#include "filebasedlogger.h"
+#include "settingsbasedblocker.h"
+
+#include <czatlib/avatarhandler.h>
+#include <czatlib/chatsession.h>
+#include <czatlib/framedecoder.h>
+#include <czatlib/loginsession.h>
+#include <czatlib/room.h>
+#include <czatlib/sessionrecording.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+struct CodeStats {
+  int count = 0;
+  qint64 totalNs = 0;
+  qint64 maxNs = 0;
+};
+
+struct ReplayStats {
+  int frames = 0;
+  qint64 handlingNs = 0;
+  std::map<int, CodeStats> perCode;
+};
+
+// returns -1 where this isn't supported.
+qint64 peakMemoryKiB() {
+#if defined(Q_OS_WIN)
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+    return static_cast<qint64>(pmc.PeakWorkingSetSize / 1024);
+  }
+  return -1;
+#elif defined(Q_OS_UNIX)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    return -1;
+  }
+#ifdef Q_OS_DARWIN
+  return usage.ru_maxrss / 1024; // reported in bytes rather than kilobytes
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return -1;
+#endif
+}
+
+bool replay(const QString &path, bool realtime, AppSettings &settings,
+            FileBasedLogger &logger, QNetworkAccessManager &nam,
+            ReplayStats &stats) {
+  Czateria::SessionRecordingReader reader(path);
+  if (!reader.isValid()) {
+    return false;
+  }
+  Czateria::Room room;
+  room.name = reader.roomName();
+  auto login = QSharedPointer<Czateria::LoginSession>::create(&nam);
+  login->setNickname(reader.nickname());
+  Czateria::AvatarHandler avatars(&nam);
+  SettingsBasedBlocker blocker(settings);
+  Czateria::ChatSession session(login, avatars, room, blocker, &logger);
+
+  QElapsedTimer clock;
+  clock.start();
+  QElapsedTimer frameClock;
+  qint64 elapsed;
+  QByteArray frame;
+  while (reader.next(elapsed, frame)) {
+    if (realtime) {
+      const auto wait = elapsed - clock.elapsed();
+      if (wait > 0) {
+        QThread::msleep(static_cast<unsigned long>(wait));
+      }
+    }
+    Czateria::FrameHeader header;
+    Czateria::FrameDecoder::peekHeader(frame, header);
+    frameClock.start();
+    session.replayFrame(frame);
+    const auto ns = frameClock.nsecsElapsed();
+    auto &codeStats = stats.perCode[header.code];
+    ++codeStats.count;
+    codeStats.totalNs += ns;
+    codeStats.maxNs = std::max(codeStats.maxNs, ns);
+    stats.handlingNs += ns;
+    ++stats.frames;
+    // let queued signals and deferred deletes run, as they would in the GUI.
+    QCoreApplication::processEvents();
+  }
+  return true;
+}
+
+void printStats(QTextStream &out, const ReplayStats &stats, qint64 wallMs) {
+  out << stats.frames << " frames in " << wallMs << " ms, "
+      << (wallMs ? stats.frames * 1000ll / wallMs : 0) << " frames/s\n";
+  out << "time spent handling frames : " << stats.handlingNs / 1000000
+      << " ms\n";
+
+  std::vector<std::pair<int, CodeStats>> sorted(std::begin(stats.perCode),
+                                                std::end(stats.perCode));
+  std::sort(std::begin(sorted), std::end(sorted), [](auto &&a, auto &&b) {
+    return a.second.totalNs > b.second.totalNs;
+  });
+  out << "\n  code     count   total ms     avg us     max us\n";
+  for (auto &&entry : sorted) {
+    auto &&s = entry.second;
+    out << qSetFieldWidth(6) << entry.first << qSetFieldWidth(10) << s.count
+        << qSetFieldWidth(11) << s.totalNs / 1000000
+        << s.totalNs / 1000 / s.count << s.maxNs / 1000 << qSetFieldWidth(0)
+        << '\n';
+  }
+
+  const auto peak = peakMemoryKiB();
+  if (peak >= 0) {
+    out << "\npeak memory usage : " << peak << " KiB\n";
+  }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  QCoreApplication::setOrganizationName(QLatin1String("xavery"));
+  QCoreApplication::setOrganizationDomain(QLatin1String("github.com"));
+  QCoreApplication::setApplicationName(QLatin1String("czateria-replay"));
+  QCoreApplication a(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(QLatin1String(
+      "Replays session recordings made with CZATERIA_RECORD_DIR set, "
+      "reporting how long handling the frames took."));
+  parser.addHelpOption();
+  QCommandLineOption realtimeOption(
+      QLatin1String("realtime"),
+      QLatin1String("Replay at the original speed instead of as fast as "
+                    "possible."));
+  QCommandLineOption repeatOption(
+      QLatin1String("repeat"),
+      QLatin1String("Replay each recording <count> times."),
+      QLatin1String("count"), QLatin1String("1"));
+  QCommandLineOption logDirOption(
+      QLatin1String("log-dir"),
+      QLatin1String("Write chat logs to <dir> instead of a temporary "
+                    "directory."),
+      QLatin1String("dir"));
+  parser.addOption(realtimeOption);
+  parser.addOption(repeatOption);
+  parser.addOption(logDirOption);
+  parser.addPositionalArgument(QLatin1String("recordings"),
+                               QLatin1String("Session recordings to replay."),
+                               QLatin1String("recordings..."));
+  parser.process(a);
+
+  const auto paths = parser.positionalArguments();
+  if (paths.isEmpty()) {
+    parser.showHelp(1);
+  }
+
+  // keep the user's actual settings out of this : everything, logs included,
+  // goes to a throwaway directory unless told otherwise.
+  QTemporaryDir tempDir;
+  if (!tempDir.isValid()) {
+    qCritical() << "Could not create a temporary directory";
+    return 1;
+  }
+  QSettings::setDefaultFormat(QSettings::IniFormat);
+  QSettings::setPath(QSettings::IniFormat, QSettings::UserScope,
+                     tempDir.path());
+  const auto logDir = parser.isSet(logDirOption) ? parser.value(logDirOption)
+                                                 : tempDir.path();
+  AppSettings settings;
+  settings.logMainChat = true;
+  settings.logJoinsParts = true;
+  settings.logPrivs = true;
+  settings.mainChatLogPath = logDir + QLatin1String("/%u/%c.log");
+  settings.privLogPath = logDir + QLatin1String("/%u/%c/%p.log");
+  FileBasedLogger logger(settings);
+  QNetworkAccessManager nam;
+
+  const auto repeat = std::max(parser.value(repeatOption).toInt(), 1);
+  const auto realtime = parser.isSet(realtimeOption);
+  ReplayStats stats;
+  QElapsedTimer wallClock;
+  wallClock.start();
+  for (int i = 0; i < repeat; ++i) {
+    for (auto &&path : paths) {
+      if (!replay(path, realtime, settings, logger, nam, stats)) {
+        qCritical().noquote() << "Could not read recording" << path;
+        return 1;
+      }
+    }
+  }
+  const auto wallMs = wallClock.elapsed();
+
+  QTextStream out(stdout);
+  printStats(out, stats, wallMs);
+  return 0;
+}
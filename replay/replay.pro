@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = czateria-replay
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../czateria.pri)
+
+QT += core network websockets
+
+win32 {
+  DEFINES += UNICODE PSAPI_VERSION=1
+  LIBS += -lpsapi
+}
+
+INCLUDEPATH += .. ../ui
+
+# the logger and its settings are taken as-is from the GUI, so that their cost
+# is measured as well.
+SOURCES += \
+    main.cpp \
+    ../ui/appsettings.cpp \
+    ../ui/filebasedlogger.cpp \
+    ../ui/settingsbasedblocker.cpp
+
+HEADERS += \
+    ../ui/appsettings.h \
+    ../ui/filebasedlogger.h \
+    ../ui/settingsbasedblocker.h
+
+win32:CONFIG (release, debug|release): LIBS += -L../czatlib/release -lczatlib
+else:win32:CONFIG (debug, debug|release): LIBS += -L../czatlib/debug -lczatlib
+else:unix: LIBS += -L../czatlib -lczatlib
+
+unix: PRE_TARGETDEPS += ../czatlib/libczatlib.a
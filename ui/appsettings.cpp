@@ -1,5 +1,15 @@
 #include "appsettings.h"
 
+#include <czatlib/chatconnection.h>
+#include <czatlib/chatsession.h>
+#include <czatlib/floodguard.h>
+#include <czatlib/imageencoder.h>
+#include <czatlib/joinscheduler.h>
+#include <czatlib/outboundqueue.h>
+#include <czatlib/pendingmessages.h>
+#include <czatlib/sessionthreads.h>
+
+#include <QDebug>
 #include <QMetaEnum>
 
 namespace {
@@ -26,6 +36,22 @@ QVector<QRegularExpression> fromVariantList(const QList<QVariant> &varList) {
   return rv;
 }
 
+Czateria::ChatSession::DispatchPolicy::Shedding
+toShedding(const QString &mode) {
+  using Shedding = Czateria::ChatSession::DispatchPolicy::Shedding;
+  if (mode == QLatin1String("off")) {
+    return Shedding::Off;
+  }
+  if (mode == QLatin1String("drop")) {
+    return Shedding::Drop;
+  }
+  if (mode != QLatin1String("summarize")) {
+    qWarning() << "Unknown background shedding mode" << mode
+               << "- summarizing instead";
+  }
+  return Shedding::Summarize;
+}
+
 void readRegexList(const QSettings &settings, const QLatin1String &key,
                    QVector<QRegularExpression> &dest) {
   auto variant = settings.value(key);
@@ -35,14 +61,6 @@ void readRegexList(const QSettings &settings, const QLatin1String &key,
 }
 } // namespace
 
-template <>
-bool (QVariant::*const AppSettings::Setting<bool>::mConvFn)() const =
-    &QVariant::toBool;
-
-template <>
-QString (QVariant::*const AppSettings::Setting<QString>::mConvFn)() const =
-    &QVariant::toString;
-
 AppSettings::AppSettings()
     : useEmojiIcons(mSettings, QLatin1String("use_emoji"), true),
       savePicturesAutomatically(mSettings, QLatin1String("auto_pic_save"),
@@ -56,7 +74,63 @@ AppSettings::AppSettings()
       mainChatLogPath(mSettings, QLatin1String("main_log_path"),
                       QLatin1String("%~/.czateria/logs/%u/%Y-%M-%D/%c.log")),
       privLogPath(mSettings, QLatin1String("priv_log_path"),
-                  QLatin1String("%~/.czateria/logs/%u/%Y-%M-%D/%c/%p.log")) {
+                  QLatin1String("%~/.czateria/logs/%u/%Y-%M-%D/%c/%p.log")),
+      warmUpConnections(mSettings, QLatin1String("warm_up_connections"),
+                        true),
+      autoBlockFlooders(mSettings, QLatin1String("auto_block_flooders"),
+                        false),
+      floodMessagesPerSecond(
+          mSettings, QLatin1String("flood_messages_per_second"),
+          Czateria::FloodGuard::Limits().messagesPerSecond),
+      floodBurst(mSettings, QLatin1String("flood_burst"),
+                 Czateria::FloodGuard::Limits().burst),
+      floodThreshold(mSettings, QLatin1String("flood_threshold"),
+                     Czateria::FloodGuard::Limits().floodThreshold),
+      privTabIdleMinutes(mSettings, QLatin1String("priv_tab_idle_minutes"),
+                         30),
+      maxPrivTabs(mSettings, QLatin1String("max_priv_tabs"), 20),
+      outboundMessagesPerSecond(
+          mSettings, QLatin1String("outbound_messages_per_second"),
+          Czateria::OutboundQueue::Limits().framesPerSecond),
+      outboundBurst(mSettings, QLatin1String("outbound_burst"),
+                    Czateria::OutboundQueue::Limits().burst),
+      outboundQueueKBytes(
+          mSettings, QLatin1String("outbound_queue_kbytes"),
+          static_cast<int>(Czateria::OutboundQueue::Limits().maxQueuedBytes /
+                           1024)),
+      priorityThreshold(
+          mSettings, QLatin1String("priority_threshold"),
+          Czateria::ChatSession::DispatchPolicy().priorityThreshold),
+      sheddingThreshold(
+          mSettings, QLatin1String("shedding_threshold"),
+          Czateria::ChatSession::DispatchPolicy().sheddingThreshold),
+      backgroundShedding(mSettings, QLatin1String("background_shedding"),
+                         QLatin1String("summarize")),
+      pendingKBytes(mSettings, QLatin1String("pending_kbytes"),
+                    static_cast<int>(
+                        Czateria::PendingMessages::Limits().maxBytes / 1024)),
+      pendingTotalKBytes(
+          mSettings, QLatin1String("pending_total_kbytes"),
+          static_cast<int>(
+              Czateria::PendingMessages::Limits().maxTotalBytes / 1024)),
+      spillPendingMessages(mSettings,
+                           QLatin1String("spill_pending_messages"), true),
+      pendingJournalKBytes(
+          mSettings, QLatin1String("pending_journal_kbytes"),
+          static_cast<int>(
+              Czateria::PendingMessages::Limits().maxJournalBytes / 1024)),
+      deadSocketSeconds(
+          mSettings, QLatin1String("dead_socket_timeout_seconds"),
+          Czateria::ChatConnection::HealthCheck().deadAfter / 1000),
+      imageBudgetKBytes(mSettings, QLatin1String("image_budget_kbytes"),
+                        Czateria::JpegEncoder::Settings().budget / 1024),
+      sessionsPerThread(mSettings, QLatin1String("sessions_per_thread"), 0),
+      concurrentJoins(mSettings, QLatin1String("concurrent_joins"),
+                      Czateria::JoinScheduler::Limits().maxConcurrent),
+      joinSpacing(mSettings, QLatin1String("join_spacing"),
+                  Czateria::JoinScheduler::Limits().spacing),
+      joinTimeout(mSettings, QLatin1String("join_timeout"),
+                  Czateria::JoinScheduler::Limits().timeout) {
 
   auto variant = mSettings.value(QLatin1String("logins"));
   if (variant.isValid() && variant.type() == QVariant::Hash) {
@@ -123,6 +197,54 @@ AppSettings::~AppSettings() {
   mSettings.endGroup();
 }
 
+void AppSettings::applyLibraryDefaults() const {
+  auto outboundLimits = Czateria::OutboundQueue::defaultLimits();
+  outboundLimits.framesPerSecond = outboundMessagesPerSecond;
+  outboundLimits.burst = outboundBurst;
+  outboundLimits.maxQueuedBytes =
+      static_cast<qint64>(outboundQueueKBytes) * 1024;
+  Czateria::OutboundQueue::setDefaultLimits(outboundLimits);
+
+  auto dispatchPolicy = Czateria::ChatSession::defaultDispatchPolicy();
+  dispatchPolicy.priorityThreshold = priorityThreshold;
+  dispatchPolicy.sheddingThreshold = sheddingThreshold;
+  dispatchPolicy.shedding = toShedding(backgroundShedding);
+  Czateria::ChatSession::setDefaultDispatchPolicy(dispatchPolicy);
+
+  auto floodLimits = Czateria::FloodGuard::defaultLimits();
+  floodLimits.messagesPerSecond = floodMessagesPerSecond;
+  floodLimits.burst = floodBurst;
+  floodLimits.floodThreshold = floodThreshold;
+  Czateria::FloodGuard::setDefaultLimits(floodLimits);
+
+  using Overflow = Czateria::PendingMessages::Overflow;
+  auto pendingLimits = Czateria::PendingMessages::defaultLimits();
+  pendingLimits.maxBytes = static_cast<qint64>(pendingKBytes) * 1024;
+  pendingLimits.maxTotalBytes = static_cast<qint64>(pendingTotalKBytes) * 1024;
+  pendingLimits.overflow =
+      spillPendingMessages ? Overflow::Spill : Overflow::DropOldest;
+  pendingLimits.maxJournalBytes =
+      static_cast<qint64>(pendingJournalKBytes) * 1024;
+  Czateria::PendingMessages::setDefaultLimits(pendingLimits);
+
+  Czateria::ChatConnection::HealthCheck healthCheck;
+  healthCheck.deadAfter = deadSocketSeconds * 1000;
+  healthCheck.pingInterval = healthCheck.deadAfter / 3;
+  Czateria::ChatConnection::setDefaultHealthCheck(healthCheck);
+
+  auto encoderSettings = Czateria::JpegEncoder::defaultSettings();
+  encoderSettings.budget = imageBudgetKBytes * 1024;
+  Czateria::JpegEncoder::setDefaultSettings(encoderSettings);
+
+  Czateria::SessionThreads::instance().setSessionsPerThread(sessionsPerThread);
+
+  auto joinLimits = Czateria::JoinScheduler::instance().limits();
+  joinLimits.maxConcurrent = concurrentJoins;
+  joinLimits.spacing = joinSpacing;
+  joinLimits.timeout = joinTimeout;
+  Czateria::JoinScheduler::instance().setLimits(joinLimits);
+}
+
 QMultiHash<Czateria::RoomListModel::LoginData, int>
 AppSettings::autologinHash() const {
   // the autologin data is stored internally as a hash of channel IDs mapping to
@@ -162,7 +284,7 @@ AppSettings::Setting<T>::Setting(QSettings &settings, QString &&key,
                                  T initialValue)
     : mSettings(settings), mKey(key) {
   auto variant = mSettings.value(key);
-  mValue = variant.isValid() ? (variant.*mConvFn)() : initialValue;
+  mValue = variant.isValid() ? variant.value<T>() : initialValue;
 }
 
 template <typename T> AppSettings::Setting<T>::~Setting() {
@@ -35,7 +35,6 @@ public:
     QSettings &mSettings;
     const QString mKey;
     T mValue;
-    static T (QVariant::*const mConvFn)() const;
   };
 
   Setting<bool> useEmojiIcons;
@@ -47,6 +46,54 @@ public:
   Setting<bool> logPrivs;
   Setting<QString> mainChatLogPath;
   Setting<QString> privLogPath;
+  // handshake with the servers of the autologin rooms as soon as the room
+  // list is known.
+  Setting<bool> warmUpConnections;
+  // block flooding users until the application exits.
+  Setting<bool> autoBlockFlooders;
+  // how many messages a second anyone may send on average and how many at
+  // once before the rest are suppressed, and how many suppressed in a row
+  // make them a flooder. a rate of 0 lets everything through.
+  Setting<double> floodMessagesPerSecond;
+  Setting<int> floodBurst;
+  Setting<int> floodThreshold;
+  // private tabs left alone for this long are closed, and so are the least
+  // recently used ones past the maximum. 0 disables either.
+  Setting<int> privTabIdleMinutes;
+  Setting<int> maxPrivTabs;
+  // how many messages a second go out to the server, how many may go out at
+  // once, and how much may wait to be sent before anything more is dropped.
+  Setting<double> outboundMessagesPerSecond;
+  Setting<int> outboundBurst;
+  Setting<int> outboundQueueKBytes;
+  // how far behind a session has to fall before it handles private messages
+  // first, and before a session in the background starts shedding room
+  // events. shedding is one of "off", "drop" or "summarize".
+  Setting<int> priorityThreshold;
+  Setting<int> sheddingThreshold;
+  Setting<QString> backgroundShedding;
+  // how much of the messages of a private conversation which hasn't been
+  // accepted yet is kept, for each one and for all of them together. past
+  // that, messages are either spilled to a journal of the given size on disk
+  // or dropped, oldest first.
+  Setting<int> pendingKBytes;
+  Setting<int> pendingTotalKBytes;
+  Setting<bool> spillPendingMessages;
+  Setting<int> pendingJournalKBytes;
+  // connections which hear nothing from the server for this many seconds are
+  // given up on. the server is pinged three times as often, and 0 turns the
+  // pinging off altogether.
+  Setting<int> deadSocketSeconds;
+  // images sent are encoded at the best quality which fits in this much.
+  Setting<int> imageBudgetKBytes;
+  // sessions whose connections share a worker thread, before another one is
+  // started. 0 keeps them all on the GUI thread.
+  Setting<int> sessionsPerThread;
+  // how many rooms are joined at once, how many milliseconds apart, and how
+  // long a join may take before the next ones stop waiting for it.
+  Setting<int> concurrentJoins;
+  Setting<int> joinSpacing;
+  Setting<int> joinTimeout;
 
   enum class NotificationStyle { MessageBox, Native };
   Q_ENUM(NotificationStyle)
@@ -58,6 +105,10 @@ public:
   QVector<QRegularExpression> blockedUsers;
   QVector<QRegularExpression> blockedContents;
 
+  // hands whatever czatlib keeps defaults for over to it. sessions which are
+  // already running have to be updated separately.
+  void applyLibraryDefaults() const;
+
 private:
   Czateria::RoomListModel::LoginData
   getAutologin(const Czateria::Room &room) const override;
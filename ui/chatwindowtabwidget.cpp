@@ -3,12 +3,18 @@
 #include <QApplication>
 #include <QDebug>
 #include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QLabel>
 #include <QPlainTextEdit>
 #include <QStackedWidget>
 #include <QTabBar>
+#include <QTemporaryDir>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <vector>
+
 #include <czatlib/message.h>
 
 namespace {
@@ -21,11 +27,15 @@ QPlainTextEdit *createTextWidget(QWidget *parent) {
 }
 
 const QColor unreadTabColor() { return QColor(Qt::red); }
+
+constexpr int idleCheckInterval = 60000;
 } // namespace
 
 class ChatWindowTabWidget::PrivateChatTab : public QStackedWidget {
   PrivateChatTab(ChatWindowTabWidget *parent, const QString &nickname)
-      : QStackedWidget(parent), mNickname(nickname) {}
+      : QStackedWidget(parent), mNickname(nickname) {
+    mLastActivity.start();
+  }
 
   void addTextWidget() {
     Q_ASSERT(!mTextWidget);
@@ -63,6 +73,7 @@ class ChatWindowTabWidget::PrivateChatTab : public QStackedWidget {
   const QString mNickname;
   QPlainTextEdit *mTextWidget = nullptr;
   PendingAcceptWidget *mPendingAcceptWidget = nullptr;
+  QElapsedTimer mLastActivity;
 
   void addPendingAcceptWidget(ChatWindowTabWidget *parent,
                               const QString &nickname) {
@@ -93,8 +104,16 @@ public:
 
   void appendPlainText(const QString &text) {
     mTextWidget->appendPlainText(text);
+    touch();
   }
 
+  QString plainText() const { return mTextWidget->toPlainText(); }
+  void setPlainText(const QString &text) { mTextWidget->setPlainText(text); }
+
+  void touch() { mLastActivity.start(); }
+  qint64 idleFor() const { return mLastActivity.elapsed(); }
+  bool isPendingAccept() const { return mPendingAcceptWidget != nullptr; }
+
   void removePendingAcceptWidget() {
     if (mPendingAcceptWidget) {
       mPendingAcceptWidget->deleteLater();
@@ -112,6 +131,21 @@ ChatWindowTabWidget::ChatWindowTabWidget(QWidget *parent)
           &ChatWindowTabWidget::onTabCloseRequested);
   connect(this, &QTabWidget::currentChanged, this,
           &ChatWindowTabWidget::updateTabActivity);
+  mIdleTimer.setInterval(idleCheckInterval);
+  connect(&mIdleTimer, &QTimer::timeout, this,
+          &ChatWindowTabWidget::closeIdleTabs);
+}
+
+ChatWindowTabWidget::~ChatWindowTabWidget() = default;
+
+void ChatWindowTabWidget::setIdleTabLimits(qint64 idleTimeout, int maxTabs) {
+  mIdleTimeout = idleTimeout;
+  mMaxTabs = maxTabs;
+  if (mIdleTimeout > 0 || mMaxTabs > 0) {
+    mIdleTimer.start();
+  } else {
+    mIdleTimer.stop();
+  }
 }
 
 void ChatWindowTabWidget::displayRoomMessage(const Czateria::Message &msg) {
@@ -119,6 +153,10 @@ void ChatWindowTabWidget::displayRoomMessage(const Czateria::Message &msg) {
   indicateTabActivity(0, QIcon(QLatin1String(":/icons/transmit_blue.png")));
 }
 
+void ChatWindowTabWidget::displayRoomInfo(const QString &str) {
+  mMainChatTab->appendPlainText(str);
+}
+
 void ChatWindowTabWidget::displayPrivateMessage(const Czateria::Message &msg) {
   auto privMsgTab = privateMessageTab(msg.nickname());
   privMsgTab->appendPlainText(formatMessage(msg));
@@ -137,6 +175,7 @@ ChatWindowTabWidget::privateMessageTab(const QString &nickname) {
   auto it = mPrivateTabs.find(nickname);
   if (it == std::end(mPrivateTabs)) {
     auto widget = PrivateChatTab::createAccepted(this, nickname);
+    restoreScrollback(widget);
     it = mPrivateTabs.insert(nickname, widget);
     addTab(widget, nickname);
   }
@@ -156,6 +195,7 @@ int ChatWindowTabWidget::countUnreadPrivateTabs() const {
 
 void ChatWindowTabWidget::askAcceptPrivateMessage(const QString &nickname) {
   auto widget = PrivateChatTab::create(this, nickname);
+  restoreScrollback(widget);
   mPrivateTabs.insert(nickname, widget);
   addTab(widget, nickname);
 }
@@ -187,6 +227,9 @@ void ChatWindowTabWidget::indicateTabActivity(QWidget *tab, const QIcon &icon) {
 void ChatWindowTabWidget::updateTabActivity(int idx) {
   tabBar()->setTabTextColor(idx, QColor());
   tabBar()->setTabIcon(idx, QIcon());
+  if (idx > 0) {
+    static_cast<PrivateChatTab *>(widget(idx))->touch();
+  }
 }
 
 QString ChatWindowTabWidget::formatMessage(const Czateria::Message &msg) const {
@@ -243,6 +286,11 @@ void ChatWindowTabWidget::addMessageToCurrent(const Czateria::Message &msg) {
   addMessageToCurrent(formatMessage(msg));
 }
 
+void ChatWindowTabWidget::addPendingMessageToCurrent(
+    const Czateria::Message &msg) {
+  addMessageToCurrent(tr("%1 (waiting to be sent)").arg(formatMessage(msg)));
+}
+
 void ChatWindowTabWidget::addMessageToCurrent(const QString &str) {
   if (currentWidget() == mMainChatTab) {
     mMainChatTab->appendPlainText(str);
@@ -263,6 +311,64 @@ void ChatWindowTabWidget::onTabCloseRequested(int index) {
   emit privateConversationClosed(nickname);
 }
 
+void ChatWindowTabWidget::closeIdleTabs() {
+  std::vector<PrivateChatTab *> candidates;
+  for (auto &&tab : mPrivateTabs) {
+    const auto idx = indexOf(tab);
+    if (idx != currentIndex() && !tab->isPendingAccept() &&
+        tabBar()->tabTextColor(idx) != unreadTabColor()) {
+      candidates.push_back(tab);
+    }
+  }
+  std::sort(std::begin(candidates), std::end(candidates),
+            [](auto a, auto b) { return a->idleFor() > b->idleFor(); });
+  auto excess = mMaxTabs > 0 ? mPrivateTabs.size() - mMaxTabs : 0;
+  for (auto tab : candidates) {
+    const auto idle = mIdleTimeout > 0 && tab->idleFor() >= mIdleTimeout;
+    if (!idle && excess <= 0) {
+      break;
+    }
+    --excess;
+    writePrivateInfo(tab, tr("Conversation closed after being left idle"),
+                     QIcon());
+    archiveScrollback(tab);
+    onTabCloseRequested(indexOf(tab));
+  }
+}
+
+QString ChatWindowTabWidget::archivePath(const QString &nickname) const {
+  // nicknames aren't necessarily valid file names.
+  return mArchiveDir->path() + QLatin1Char('/') +
+         QString::fromLatin1(nickname.toUtf8().toHex());
+}
+
+void ChatWindowTabWidget::archiveScrollback(PrivateChatTab *tab) {
+  if (!mArchiveDir) {
+    mArchiveDir = std::make_unique<QTemporaryDir>();
+  }
+  if (!mArchiveDir->isValid()) {
+    qInfo() << "Could not create a directory for archiving conversations";
+    return;
+  }
+  QFile file(archivePath(tab->nickname()));
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text) ||
+      file.write(tab->plainText().toUtf8()) < 0) {
+    qInfo() << "Could not archive the conversation with" << tab->nickname()
+            << ":" << file.errorString();
+  }
+}
+
+void ChatWindowTabWidget::restoreScrollback(PrivateChatTab *tab) {
+  if (!mArchiveDir || !mArchiveDir->isValid()) {
+    return;
+  }
+  QFile file(archivePath(tab->nickname()));
+  if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    tab->setPlainText(QString::fromUtf8(file.readAll()));
+    file.remove();
+  }
+}
+
 void ChatWindowTabWidget::writePrivateInfo(PrivateChatTab *tab,
                                            const QString &message,
                                            const QIcon &icon) {
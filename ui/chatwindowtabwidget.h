@@ -3,6 +3,9 @@
 
 #include <QHash>
 #include <QTabWidget>
+#include <QTimer>
+
+#include <memory>
 
 #include <czatlib/conversationstate.h>
 
@@ -11,14 +14,17 @@ class Message;
 }
 
 class QPlainTextEdit;
+class QTemporaryDir;
 
 class ChatWindowTabWidget : public QTabWidget {
   Q_OBJECT
 public:
   ChatWindowTabWidget(QWidget *parent = nullptr);
+  ~ChatWindowTabWidget() override;
 
   void displayRoomMessage(const Czateria::Message &msg);
   void displayPrivateMessage(const Czateria::Message &msg);
+  void displayRoomInfo(const QString &str);
   void openPrivateMessageTab(const QString &nickname);
   void onPrivateConversationStateChanged(const QString &nickname,
                                          Czateria::ConversationState state);
@@ -26,6 +32,8 @@ public:
 
   void addMessageToCurrent(const Czateria::Message &msg);
   void addMessageToCurrent(const QString &str);
+  // for our own messages which couldn't be sent right away.
+  void addPendingMessageToCurrent(const Czateria::Message &msg);
   int countUnreadPrivateTabs() const;
   void askAcceptPrivateMessage(const QString &nickname);
   void addMessageToPrivateChat(const QString &nickname, const QString &str);
@@ -37,6 +45,11 @@ public:
   void closePrivateConversationTab(const QString &nickname);
   void writeConversationState(const QString &nickname, const QString &message,
                               const QIcon &icon);
+  // private tabs left alone for longer than idleTimeout milliseconds are
+  // closed, and so are the least recently used ones past maxTabs. 0 disables
+  // either. what they contained is brought back once they're opened again.
+  // tabs which are current, unread or waiting to be accepted are kept.
+  void setIdleTabLimits(qint64 idleTimeout, int maxTabs);
 
 signals:
   void privateConversationAccepted(const QString &nickname);
@@ -54,10 +67,20 @@ private:
   void writePrivateInfo(PrivateChatTab *, const QString &message,
                         const QIcon &icon);
   PrivateChatTab *privateMessageTab(const QString &nickname);
+  void closeIdleTabs();
+  QString archivePath(const QString &nickname) const;
+  void archiveScrollback(PrivateChatTab *tab);
+  void restoreScrollback(PrivateChatTab *tab);
 
   QPlainTextEdit *const mMainChatTab;
   QHash<QString, PrivateChatTab *> mPrivateTabs;
   bool mUseEmoji;
+
+  qint64 mIdleTimeout = 0;
+  int mMaxTabs = 0;
+  QTimer mIdleTimer;
+  // created once the first tab is archived, and gone along with the window.
+  std::unique_ptr<QTemporaryDir> mArchiveDir;
 };
 
 #endif // CHATWINDOWTABWIDGET_H
@@ -67,6 +67,16 @@ static const QRegularExpression privTokensRgx(QLatin1String("%[" COMMON_TOKENS
 
 #undef COMMON_TOKENS
 
+QByteArray messageLine(const QString &nickname, const QByteArray &utf8Message) {
+  QByteArray rv;
+  rv.reserve(utf8Message.size() + 2 * nickname.size() + 3);
+  rv.append('<');
+  rv.append(nickname.toUtf8());
+  rv.append("> ", 2);
+  rv.append(utf8Message);
+  return rv;
+}
+
 QFileInfo makeRoomLogPath(const QString &path,
                           const Czateria::ChatSession *session) {
   return makeLogPath(path, roomTokensRgx, session,
@@ -96,8 +106,7 @@ void FileBasedLogger::onRoomMessage(const Czateria::ChatSession *session,
   }
   auto fi = makeRoomLogPath(mSettings.mainChatLogPath, session);
   writeLogEntry(fi, msg.receivedAt(), [&]() {
-    return QString(QLatin1String("<%1> %2"))
-        .arg(msg.nickname(), msg.rawMessage());
+    return messageLine(msg.nickname(), msg.rawMessageUtf8());
   });
 }
 
@@ -109,8 +118,7 @@ void FileBasedLogger::onPrivateMessageReceived(
 
   auto fi = makePrivLogPath(mSettings.privLogPath, session, message);
   writeLogEntry(fi, message.receivedAt(), [&]() {
-    return QString(QLatin1String("<%1> %2"))
-        .arg(message.nickname(), message.rawMessage());
+    return messageLine(message.nickname(), message.rawMessageUtf8());
   });
 }
 
@@ -121,8 +129,7 @@ void FileBasedLogger::onPrivateMessageSent(const Czateria::ChatSession *session,
   }
   auto fi = makePrivLogPath(mSettings.privLogPath, session, message);
   writeLogEntry(fi, message.receivedAt(), [&]() {
-    return QString(QLatin1String("<%1> %2"))
-        .arg(session->nickname(), message.rawMessage());
+    return messageLine(session->nickname(), message.rawMessageUtf8());
   });
 }
 
@@ -134,7 +141,9 @@ void FileBasedLogger::onUserJoined(const Czateria::ChatSession *session,
 
   auto fi = makeRoomLogPath(mSettings.mainChatLogPath, session);
   writeLogEntry(fi, QDateTime::currentDateTime(), [&]() {
-    return QString(QLatin1String(">>> %1 joined the room")).arg(nickname);
+    return QString(QLatin1String(">>> %1 joined the room"))
+        .arg(nickname)
+        .toUtf8();
   });
 }
 
@@ -146,7 +155,9 @@ void FileBasedLogger::onUserLeft(const Czateria::ChatSession *session,
 
   auto fi = makeRoomLogPath(mSettings.mainChatLogPath, session);
   writeLogEntry(fi, QDateTime::currentDateTime(), [&]() {
-    return QString(QLatin1String("<<< %1 left the room")).arg(nickname);
+    return QString(QLatin1String("<<< %1 left the room"))
+        .arg(nickname)
+        .toUtf8();
   });
 }
 
@@ -174,10 +185,15 @@ void FileBasedLogger::writeLogEntry(const QFileInfo &fileInfo,
                                     const QDateTime &timestamp,
                                     F &&outputGenFn) {
   if (auto f = getOpenFile(fileInfo)) {
-    auto str =
-        QString(QLatin1String("[%1] %2\n"))
-            .arg(timestamp.toString(QLatin1String("HH:mm:ss")), outputGenFn());
-    f->write(str.toUtf8());
+    // the entries are generated as UTF-8 already, in order to avoid converting
+    // every received message back and forth.
+    QByteArray line;
+    line.append('[');
+    line.append(timestamp.toString(QLatin1String("HH:mm:ss")).toLatin1());
+    line.append("] ", 2);
+    line.append(outputGenFn());
+    line.append('\n');
+    f->write(line);
     f->flush();
   }
 }
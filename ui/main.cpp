@@ -1,8 +1,14 @@
 #include "appsettings.h"
 #include "filebasedlogger.h"
 #include "mainwindow.h"
+#include "tracedumpsignal.h"
+
+#include <czatlib/outbox.h>
+#include <czatlib/sessionrecording.h>
+#include <czatlib/wiretrace.h>
 
 #include <QApplication>
+#include <QLoggingCategory>
 #include <QNetworkAccessManager>
 #include <QNetworkDiskCache>
 #include <QNetworkProxyFactory>
@@ -28,6 +34,9 @@ int main(int argc, char **argv) {
 #endif
                                    "%{message}"));
   defaultHandler = qInstallMessageHandler(msgOutput);
+  if (qEnvironmentVariableIsSet("CZATERIA_DEBUG")) {
+    QLoggingCategory::setFilterRules(QLatin1String("czateria.wire.debug=true"));
+  }
   QCoreApplication::setOrganizationName(QLatin1String("xavery"));
   QCoreApplication::setOrganizationDomain(QLatin1String("github.com"));
   QCoreApplication::setApplicationName(QLatin1String("czateria"));
@@ -38,7 +47,22 @@ int main(int argc, char **argv) {
   cache->setCacheDirectory(
       QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
   nam.setCache(cache);
+  Czateria::WireTrace::setDumpDirectory(
+      qEnvironmentVariableIsSet("CZATERIA_TRACE_DIR")
+          ? QString::fromLocal8Bit(qgetenv("CZATERIA_TRACE_DIR"))
+          : QStandardPaths::writableLocation(
+                QStandardPaths::AppLocalDataLocation) +
+                QLatin1String("/traces"));
+  installTraceDumpSignalHandler(&a);
+  Czateria::Outbox::setDirectory(
+      QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) +
+      QLatin1String("/outbox"));
+  if (qEnvironmentVariableIsSet("CZATERIA_RECORD_DIR")) {
+    Czateria::SessionRecorder::setRecordDirectory(
+        QString::fromLocal8Bit(qgetenv("CZATERIA_RECORD_DIR")));
+  }
   AppSettings settings;
+  settings.applyLibraryDefaults();
   FileBasedLogger l(settings);
   MainWindow w(&nam, settings, &l);
   w.show();
@@ -13,18 +13,23 @@
 #include <QDropEvent>
 #include <QFileDialog>
 #include <QImageReader>
+#include <QLabel>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QPlainTextEdit>
 #include <QPushButton>
 #include <QSortFilterProxyModel>
 #include <QStandardPaths>
+#include <QStatusBar>
 #include <QToolBar>
 #include <QUrl>
 
 #include <czatlib/chatblocker.h>
 #include <czatlib/chatsession.h>
+#include <czatlib/joinscheduler.h>
 #include <czatlib/message.h>
+#include <czatlib/sessionmanager.h>
+#include <czatlib/sessionmetrics.h>
 #include <czatlib/userlistmodel.h>
 
 namespace {
@@ -193,16 +198,14 @@ private:
   }
 };
 
-MainChatWindow::MainChatWindow(QSharedPointer<Czateria::LoginSession> login,
-                               Czateria::AvatarHandler &avatars,
+MainChatWindow::MainChatWindow(Czateria::SessionManager &sessions,
+                               QSharedPointer<Czateria::LoginSession> login,
                                const Czateria::Room &room,
                                const AppSettings &settings,
-                               const Czateria::ChatBlocker &blocker,
-                               Czateria::ChatSessionListener *listener,
+                               Czateria::ChatBlocker &blocker,
                                MainWindow *mainWin)
     : QMainWindow(nullptr), ui(new Ui::ChatWidget), mMainWindow(mainWin),
-      mChatSession(new Czateria::ChatSession(login, avatars, room, blocker,
-                                             listener, this)),
+      mChatSession(sessions.createChatSession(login, room, this)),
       mSortProxy(new QSortFilterProxyModel(this)),
       mNicknameCompleter(
           createNicknameCompleter(mChatSession->userListModel(), this)),
@@ -264,6 +267,7 @@ MainChatWindow::MainChatWindow(QSharedPointer<Czateria::LoginSession> login,
   toolbar->addAction(mSettingsAction);
 
   ui->tabWidget->setUseEmoji(settings.useEmojiIcons);
+  applySettings(settings);
 
   auto desiredWidth = getOptimalUserListWidth(ui->listView);
   ui->widget_3->setMaximumSize(QSize(desiredWidth, QWIDGETSIZE_MAX));
@@ -279,7 +283,7 @@ MainChatWindow::MainChatWindow(QSharedPointer<Czateria::LoginSession> login,
 
   ui->listView->setModel(mSortProxy);
   ui->listView->setUserListModel(mChatSession->userListModel());
-  ui->listView->setAvatarHandler(&avatars);
+  ui->listView->setAvatarHandler(&sessions.avatars());
 
   ui->nicknameLabel->setText(mChatSession->nickname());
   setAttribute(Qt::WA_DeleteOnClose);
@@ -296,6 +300,49 @@ MainChatWindow::MainChatWindow(QSharedPointer<Czateria::LoginSession> login,
           this, &MainChatWindow::onPrivateConversationCancelled);
   connect(mChatSession, &Czateria::ChatSession::userLeft, this,
           &MainChatWindow::onUserLeft);
+  connect(mChatSession, &Czateria::ChatSession::eventsShed, this,
+          &MainChatWindow::onEventsShed);
+  connect(mChatSession, &Czateria::ChatSession::pendingMessagesDropped, this,
+          [=](auto &&nickname, int count) {
+            ui->tabWidget->addMessageToPrivateChat(
+                nickname,
+                tr("%1 earlier messages were dropped, there were too many "
+                   "to keep")
+                    .arg(count));
+          });
+  connect(mChatSession, &Czateria::ChatSession::outboxSent, this,
+          [=](int count) {
+            ui->tabWidget->displayRoomInfo(
+                tr("%1 messages which were waiting have been sent")
+                    .arg(count));
+          });
+  connect(mChatSession, &Czateria::ChatSession::outboxExpired, this,
+          [=](int count) {
+            ui->tabWidget->displayRoomInfo(
+                tr("%1 messages typed while disconnected were not sent, "
+                   "they waited too long")
+                    .arg(count));
+          });
+  connect(mChatSession, &Czateria::ChatSession::sendDropped, this,
+          [=](bool image) {
+            ui->tabWidget->displayRoomInfo(
+                image ? tr("An image was not sent, too much was already "
+                           "waiting to be sent")
+                      : tr("A message was not sent, too much was already "
+                           "waiting to be sent"));
+          });
+  connect(mChatSession, &Czateria::ChatSession::roundTripMeasured, this,
+          &MainChatWindow::updateLatency);
+  connect(mChatSession, &Czateria::ChatSession::messagesSuppressed, this,
+          &MainChatWindow::onMessagesSuppressed);
+  connect(mChatSession, &Czateria::ChatSession::floodDetected, this,
+          [&settings, &blocker](auto &&nickname) {
+            // read right here, so that changing the setting applies to the
+            // windows which are already open.
+            if (settings.autoBlockFlooders) {
+              blocker.blockTemporarily(nickname);
+            }
+          });
   connect(mChatSession, &Czateria::ChatSession::privateConversationStateChanged,
           ui->tabWidget,
           &ChatWindowTabWidget::onPrivateConversationStateChanged);
@@ -385,10 +432,35 @@ MainChatWindow::MainChatWindow(QSharedPointer<Czateria::LoginSession> login,
 
   ui->lineEdit->installEventFilter(this);
 
-  mChatSession->start();
+  connect(mChatSession->userListModel(),
+          &Czateria::UserListModel::snapshotApplied, this, [=]() {
+            if (mJoinId) {
+              Czateria::JoinScheduler::instance().finished(mJoinId);
+              mJoinId = 0;
+            }
+          });
+  // the window isn't shown yet, showing it bumps the priority.
+  mJoinId = Czateria::JoinScheduler::instance().add(
+      [=]() { mChatSession->start(); },
+      Czateria::JoinScheduler::Priority::Hidden);
 }
 
-MainChatWindow::~MainChatWindow() { delete ui; }
+MainChatWindow::~MainChatWindow() {
+  if (mJoinId) {
+    Czateria::JoinScheduler::instance().remove(mJoinId);
+  }
+  delete ui;
+}
+
+void MainChatWindow::applySettings(const AppSettings &settings) {
+  ui->tabWidget->setIdleTabLimits(
+      static_cast<qint64>(settings.privTabIdleMinutes) * 60 * 1000,
+      settings.maxPrivTabs);
+  mChatSession->setOutboundLimits(Czateria::OutboundQueue::defaultLimits());
+  mChatSession->setDispatchPolicy(
+      Czateria::ChatSession::defaultDispatchPolicy());
+  mChatSession->setFloodLimits(Czateria::FloodGuard::defaultLimits());
+}
 
 void MainChatWindow::onPrivateConvNotificationAccepted(
     const QString &nickname) {
@@ -415,16 +487,29 @@ void MainChatWindow::onNewPrivateConversation(const QString &nickname) {
 void MainChatWindow::onReturnPressed() {
   auto text = ui->lineEdit->text();
   auto currentNickname = ui->tabWidget->getCurrentNickname();
+  using SendResult = Czateria::ChatSession::SendResult;
+  SendResult result;
   if (currentNickname.isNull()) {
-    mChatSession->sendRoomMessage(text);
+    result = mChatSession->sendRoomMessage(text);
   } else if (mChatSession->canSendMessage(currentNickname)) {
-    mChatSession->sendPrivateMessage(currentNickname, text);
+    result = mChatSession->sendPrivateMessage(currentNickname, text);
   } else {
     return;
   }
   ui->lineEdit->clear();
-  ui->tabWidget->addMessageToCurrent(
-      {QDateTime::currentDateTime(), text, mChatSession->nickname()});
+  const Czateria::Message msg(QDateTime::currentDateTime(), text,
+                              mChatSession->nickname());
+  switch (result) {
+  case SendResult::Sent:
+    ui->tabWidget->addMessageToCurrent(msg);
+    break;
+  case SendResult::Queued:
+    ui->tabWidget->addPendingMessageToCurrent(msg);
+    break;
+  case SendResult::Resubmitted:
+    // already shown as waiting.
+    break;
+  }
 }
 
 void MainChatWindow::onUserNameDoubleClicked(const QModelIndex &proxyIdx) {
@@ -539,6 +624,85 @@ void MainChatWindow::dropEvent(QDropEvent *ev) {
   ev->acceptProposedAction();
 }
 
+void MainChatWindow::onEventsShed(int messages, int joins, int parts) {
+  const auto time =
+      QDateTime::currentDateTime().toString(QLatin1String("HH:mm:ss"));
+  ui->tabWidget->displayRoomInfo(
+      tr("[%1] Room too busy, skipped %2 messages, %3 joins and %4 parts")
+          .arg(time)
+          .arg(messages)
+          .arg(joins)
+          .arg(parts));
+}
+
+void MainChatWindow::onMessagesSuppressed(const QString &nickname,
+                                          int count) {
+  const auto time =
+      QDateTime::currentDateTime().toString(QLatin1String("HH:mm:ss"));
+  const auto text = tr("[%1] %2 messages from %3 suppressed")
+                        .arg(time)
+                        .arg(count)
+                        .arg(nickname);
+  if (ui->tabWidget->privTabIsOpen(nickname)) {
+    ui->tabWidget->addMessageToPrivateChat(nickname, text);
+  } else {
+    ui->tabWidget->displayRoomInfo(text);
+  }
+}
+
+void MainChatWindow::updateLatency() {
+  if (!mLatencyLabel) {
+    // no status bar until there's something to show in it.
+    mLatencyLabel = new QLabel;
+    mLatencyLabel->setToolTip(
+        tr("How long it takes for your messages in the main chat to come "
+           "back from the server : the median, and the worst out of a "
+           "hundred"));
+    statusBar()->addPermanentWidget(mLatencyLabel);
+  }
+  const auto &rtt = mChatSession->metrics().echoRtt;
+  mLatencyLabel->setText(tr("Server round trip : %1 ms, p99 %2 ms")
+                             .arg(rtt.percentile(50))
+                             .arg(rtt.percentile(99)));
+}
+
+void MainChatWindow::updateBackgrounded() {
+  mChatSession->setBackgrounded(!isVisible() || isMinimized());
+}
+
+void MainChatWindow::updateJoinPriority() {
+  if (!mJoinId) {
+    return;
+  }
+  using Priority = Czateria::JoinScheduler::Priority;
+  const auto priority = isActiveWindow()                ? Priority::Focused
+                        : !isVisible() || isMinimized() ? Priority::Hidden
+                                                        : Priority::Visible;
+  Czateria::JoinScheduler::instance().setPriority(mJoinId, priority);
+}
+
+void MainChatWindow::showEvent(QShowEvent *ev) {
+  QMainWindow::showEvent(ev);
+  updateBackgrounded();
+  updateJoinPriority();
+}
+
+void MainChatWindow::hideEvent(QHideEvent *ev) {
+  QMainWindow::hideEvent(ev);
+  updateBackgrounded();
+  updateJoinPriority();
+}
+
+void MainChatWindow::changeEvent(QEvent *ev) {
+  QMainWindow::changeEvent(ev);
+  if (ev->type() == QEvent::WindowStateChange) {
+    updateBackgrounded();
+    updateJoinPriority();
+  } else if (ev->type() == QEvent::ActivationChange) {
+    updateJoinPriority();
+  }
+}
+
 bool MainChatWindow::eventFilter(QObject *obj, QEvent *ev) {
   if (obj == ui->lineEdit && ev->type() == QEvent::KeyPress) {
     auto keyEv = static_cast<QKeyEvent *>(ev);
@@ -11,6 +11,7 @@ class QMessageBox;
 struct AppSettings;
 class MainWindow;
 class QMimeData;
+class QLabel;
 
 namespace Ui {
 class ChatWidget;
@@ -20,27 +21,26 @@ namespace Czateria {
 class LoginSession;
 class ChatSession;
 class Message;
-class AvatarHandler;
 struct Room;
 class ChatBlocker;
-struct ChatSessionListener;
+class SessionManager;
 } // namespace Czateria
 
 class MainChatWindow : public QMainWindow {
   Q_OBJECT
 
 public:
-  explicit MainChatWindow(QSharedPointer<Czateria::LoginSession> login,
-                          Czateria::AvatarHandler &avatars,
+  explicit MainChatWindow(Czateria::SessionManager &sessions,
+                          QSharedPointer<Czateria::LoginSession> login,
                           const Czateria::Room &room,
                           const AppSettings &settings,
-                          const Czateria::ChatBlocker &blocker,
-                          Czateria::ChatSessionListener *listener,
-                          MainWindow *mainWin);
+                          Czateria::ChatBlocker &blocker, MainWindow *mainWin);
   ~MainChatWindow();
 
   void onPrivateConvNotificationAccepted(const QString &nickname);
   void onPrivateConvNotificationRejected(const QString &nickname);
+  // updates the session with what was changed in the settings.
+  void applySettings(const AppSettings &settings);
 
 private:
   void onNewPrivateConversation(const QString &nickname);
@@ -54,9 +54,17 @@ private:
   bool sendImageFromMime(const QMimeData *);
   void onUserLeft(const QString &);
   void onPrivateConversationCancelled(const QString &);
+  void onEventsShed(int messages, int joins, int parts);
+  void onMessagesSuppressed(const QString &nickname, int count);
+  void updateBackgrounded();
+  void updateJoinPriority();
+  void updateLatency();
 
   void dragEnterEvent(QDragEnterEvent *) override;
   void dropEvent(QDropEvent *) override;
+  void showEvent(QShowEvent *) override;
+  void hideEvent(QHideEvent *) override;
+  void changeEvent(QEvent *) override;
 
   bool eventFilter(QObject *, QEvent *) override;
 
@@ -69,6 +77,9 @@ private:
   QAction *const mShowChannelListAction;
   QAction *const mSendImageAction;
   QAction *const mSettingsAction;
+  QLabel *mLatencyLabel = nullptr;
+  // only there until the room is joined.
+  int mJoinId = 0;
 
   bool mAutoAcceptPrivs;
   bool mAutoSavePictures;
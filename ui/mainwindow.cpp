@@ -8,8 +8,12 @@
 #include "settingsdialog.h"
 #include "util.h"
 
+#include <czatlib/endpoints.h>
+#include <czatlib/joinscheduler.h>
 #include <czatlib/loginsession.h>
+#include <czatlib/pendingconnections.h>
 #include <czatlib/roomlistmodel.h>
+#include <czatlib/tlssessioncache.h>
 
 #include <QActionGroup>
 #include <QCloseEvent>
@@ -21,6 +25,8 @@
 #include <QSharedPointer>
 #include <QSortFilterProxyModel>
 
+#include <algorithm>
+
 namespace {
 template <typename F1, typename F2, typename F3>
 auto inspectRadioButtons(Ui::MainWindow *ui, F1 noNicknameFn, F2 nicknameFn,
@@ -121,11 +127,15 @@ public:
 
 private:
   void createSession() {
-    auto session = new Czateria::LoginSession(mMainWindow->mNAM);
+    auto session = mMainWindow->mSessions.createLoginSession();
     auto rooms = mLoginHash.values(*mLoginIter);
 
     oneshotConnect(
         session, &Czateria::LoginSession::loginSuccessful, this, [=]() {
+          // the session may log back in later on, failing to do so is not
+          // this one's concern anymore.
+          disconnect(session, &Czateria::LoginSession::loginFailed, this,
+                     nullptr);
           auto ses = QSharedPointer<Czateria::LoginSession>(session);
           for (auto roomId : rooms) {
             if (auto room = mMainWindow->mRoomListModel->roomFromId(roomId)) {
@@ -150,6 +160,17 @@ private:
     const auto loginRoom = rooms[0];
     if (auto room = mMainWindow->mRoomListModel->roomFromId(loginRoom)) {
       session->login(*room, mLoginIter->username, mLoginIter->password);
+      // the rest of the rooms are joined one after another anyway, and their
+      // connections opened ahead would only be waiting around.
+      const auto aheadCount = std::min(
+          rooms.size(),
+          Czateria::JoinScheduler::instance().limits().maxConcurrent);
+      for (int i = 0; i < aheadCount; ++i) {
+        if (auto r = mMainWindow->mRoomListModel->roomFromId(rooms[i])) {
+          Czateria::PendingConnections::instance().open(
+              *r, session->nickname(), mMainWindow->mBlocker);
+        }
+      }
     } else {
       qWarning() << "Room" << loginRoom
                  << "not found while performing initial login for"
@@ -176,13 +197,13 @@ private:
 
 MainWindow::MainWindow(QNetworkAccessManager *nam, AppSettings &settings,
                        Czateria::ChatSessionListener *listener, QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), mNAM(nam),
+    : QMainWindow(parent), ui(new Ui::MainWindow),
       mRoomListModel(new Czateria::RoomListModel(this, nam, settings)),
-      mRoomSortModel(new QSortFilterProxyModel(this)), mAvatarHandler(nam),
-      mAppSettings(settings),
+      mRoomSortModel(new QSortFilterProxyModel(this)), mAppSettings(settings),
       mNotifications(createNotificationSupport(settings.notificationStyle)),
-      mBlocker(settings), mListener(listener) {
+      mBlocker(settings), mSessions(nam, mBlocker) {
   ui->setupUi(this);
+  mSessions.addListener(listener);
 
   auto refreshAct =
       new QAction(QApplication::style()->standardIcon(QStyle::SP_BrowserReload),
@@ -202,6 +223,10 @@ MainWindow::MainWindow(QNetworkAccessManager *nam, AppSettings &settings,
       mNotifications =
           createNotificationSupport(mAppSettings.notificationStyle);
       emit mBlocker.changed();
+      mAppSettings.applyLibraryDefaults();
+      for (auto win : mChatWindows) {
+        win->applySettings(mAppSettings);
+      }
     }
   });
   ui->mainToolBar->addAction(settingsAct);
@@ -237,6 +262,14 @@ MainWindow::MainWindow(QNetworkAccessManager *nam, AppSettings &settings,
   oneshotConnect(mRoomListModel, &Czateria::RoomListModel::finished, this,
                  [=]() {
                    auto logins = mAppSettings.autologinHash();
+                   if (mAppSettings.warmUpConnections) {
+                     for (auto roomId : logins.values()) {
+                       if (auto room = mRoomListModel->roomFromId(roomId)) {
+                         Czateria::TlsSessionCache::instance().warmUp(
+                             Czateria::Endpoints::chatServer(room->port));
+                       }
+                     }
+                   }
                    if (!logins.empty()) {
                      new AutologinState(
                          this, std::move(logins)); // self-destructs when done.
@@ -269,7 +302,7 @@ void MainWindow::onChannelDoubleClicked(const QModelIndex &idx) {
   if (ui->nicknameOnlyRadioButton->isChecked() ||
       ui->nickAndPassRadioButton->isChecked()) {
     auto nickname = ui->nicknameLineEdit->text();
-    if (auto session = mCurrentSessions.value(nickname).toStrongRef()) {
+    if (auto session = mSessions.loginSession(nickname)) {
       createChatWindow(session, room);
       newSessionNeeded = false;
     }
@@ -325,19 +358,25 @@ void MainWindow::onLoginFailed(Czateria::LoginFailReason why,
 }
 
 void MainWindow::startLogin(const Czateria::Room &room) {
-  auto session = new Czateria::LoginSession(mNAM);
+  auto session = mSessions.createLoginSession();
   connect(session, &Czateria::LoginSession::captchaRequired, this,
           [=](const QImage &image) {
             QApplication::restoreOverrideCursor();
             CaptchaDialog dialog(image, this);
             if (dialog.exec() == QDialog::Accepted) {
               session->setCaptchaReply(room, dialog.response());
+              Czateria::PendingConnections::instance().open(
+                  room, session->nickname(), mBlocker);
             } else {
               blockUi(ui, false);
             }
           });
   oneshotConnect(
       session, &Czateria::LoginSession::loginSuccessful, this, [=]() {
+        // from now on the session is owned by the chat windows, which handle
+        // any failures to log back in themselves.
+        disconnect(session, &Czateria::LoginSession::loginFailed, this,
+                   nullptr);
         blockUi(ui, false);
         if (ui->nicknameLineEdit->isEnabled()) {
           ui->nicknameLineEdit->setText(session->nickname());
@@ -354,6 +393,8 @@ void MainWindow::startLogin(const Czateria::Room &room) {
       [&](auto &&nickname) { session->login(nickname); },
       [&](auto &&nickname, auto &&password) {
         session->login(room, nickname, password);
+        Czateria::PendingConnections::instance().open(
+            room, session->nickname(), mBlocker);
         connect(session, &Czateria::LoginSession::loginSuccessful, [=]() {
           if (ui->saveCredentialsCheckBox) {
             saveLoginData(nickname, password);
@@ -375,12 +416,9 @@ void MainWindow::createChatWindow(
   // we keep our own list of this instead of using parenting because
   // having these windows as children of MainWindow causes
   // QApplication::alert not to work properly.
-  auto win = new MainChatWindow(session, mAvatarHandler, room, mAppSettings,
-                                mBlocker, mListener, this);
+  auto win = new MainChatWindow(mSessions, session, room, mAppSettings,
+                                mBlocker, this);
   mChatWindows.push_back(win);
-  if (!session->nickname().isEmpty()) {
-    mCurrentSessions[session->nickname()] = session.toWeakRef();
-  }
   connect(win, &QObject::destroyed, this,
           [=]() { mChatWindows.removeAll(win); });
   win->show();
@@ -1,13 +1,11 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#include <QHash>
 #include <QMainWindow>
 #include <QStringListModel>
-#include <QWeakPointer>
 
-#include <czatlib/avatarhandler.h>
 #include <czatlib/loginfailreason.h>
+#include <czatlib/sessionmanager.h>
 
 #include "notificationsupport.h"
 #include "settingsbasedblocker.h"
@@ -47,17 +45,14 @@ protected:
 
 private:
   Ui::MainWindow *ui;
-  QNetworkAccessManager *const mNAM;
   Czateria::RoomListModel *const mRoomListModel;
   QSortFilterProxyModel *const mRoomSortModel;
-  Czateria::AvatarHandler mAvatarHandler;
   QStringListModel mSavedLoginsModel;
   AppSettings &mAppSettings;
   QList<MainChatWindow *> mChatWindows;
-  QHash<QString, QWeakPointer<Czateria::LoginSession>> mCurrentSessions;
   std::unique_ptr<NotificationSupport> mNotifications;
   SettingsBasedBlocker mBlocker;
-  Czateria::ChatSessionListener *mListener;
+  Czateria::SessionManager mSessions;
 
   void onChannelDoubleClicked(const QModelIndex &);
   void onChannelClicked(const QModelIndex &);
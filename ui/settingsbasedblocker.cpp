@@ -15,10 +15,43 @@ bool tryMatch(const QString &subject,
 }
 } // namespace
 
+SettingsBasedBlocker::SettingsBasedBlocker(const AppSettings &settings)
+    : mSettings(settings) {
+  update();
+  // connected before anyone else gets the chance to, so that everyone sees
+  // the updated lists.
+  connect(this, &ChatBlocker::changed, this, &SettingsBasedBlocker::update);
+}
+
+void SettingsBasedBlocker::update() {
+  QWriteLocker lock(&mLock);
+  mBlockedUsers = mSettings.blockedUsers;
+  mBlockedContents = mSettings.blockedContents;
+}
+
 bool SettingsBasedBlocker::isUserBlocked(const QString &nickname) const {
-  return tryMatch(nickname, mSettings.blockedUsers);
+  QReadLocker lock(&mLock);
+  return mTemporarilyBlocked.contains(nickname) ||
+         tryMatch(nickname, mBlockedUsers);
 }
 
 bool SettingsBasedBlocker::isMessageBlocked(const QString &content) const {
-  return tryMatch(content, mSettings.blockedContents);
+  QReadLocker lock(&mLock);
+  return tryMatch(content, mBlockedContents);
+}
+
+bool SettingsBasedBlocker::hasMessageFilters() const {
+  QReadLocker lock(&mLock);
+  return !mBlockedContents.isEmpty();
+}
+
+void SettingsBasedBlocker::blockTemporarily(const QString &nickname) {
+  {
+    QWriteLocker lock(&mLock);
+    if (mTemporarilyBlocked.contains(nickname)) {
+      return;
+    }
+    mTemporarilyBlocked.insert(nickname);
+  }
+  emit changed();
 }
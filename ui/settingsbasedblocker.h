@@ -3,17 +3,32 @@
 
 #include <czatlib/chatblocker.h>
 
+#include <QReadWriteLock>
+#include <QRegularExpression>
+#include <QSet>
+#include <QVector>
+
 struct AppSettings;
 
 class SettingsBasedBlocker : public Czateria::ChatBlocker {
 public:
-  SettingsBasedBlocker(const AppSettings &settings) : mSettings(settings) {}
+  SettingsBasedBlocker(const AppSettings &settings);
 
 private:
   const AppSettings &mSettings;
+  // copies of what's in the settings, taken whenever the blocker changes.
+  // the settings themselves can't be read while they're being edited.
+  mutable QReadWriteLock mLock;
+  QVector<QRegularExpression> mBlockedUsers;
+  QVector<QRegularExpression> mBlockedContents;
+  QSet<QString> mTemporarilyBlocked;
+
+  void update();
 
   bool isUserBlocked(const QString &nickname) const override;
   bool isMessageBlocked(const QString &content) const override;
+  bool hasMessageFilters() const override;
+  void blockTemporarily(const QString &nickname) override;
 };
 
 #endif // SETTINGSBASEDBLOCKER_H
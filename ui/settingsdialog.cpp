@@ -67,9 +67,12 @@ void SettingsDialog::readSettings() {
   uiForm->useEmojiIcons->setChecked(mAppSettings.useEmojiIcons);
   ui->notifStyleComboBox->setCurrentIndex(
       static_cast<int>(mAppSettings.notificationStyle));
+  ui->privTabIdleSpinBox->setValue(mAppSettings.privTabIdleMinutes);
+  ui->maxPrivTabsSpinBox->setValue(mAppSettings.maxPrivTabs);
 
   fillListWidget(ui->blockedMsgsList, mAppSettings.blockedContents);
   fillListWidget(ui->blockedUsersList, mAppSettings.blockedUsers);
+  ui->autoBlockFloodersCheckBox->setChecked(mAppSettings.autoBlockFlooders);
 
   ui->logGeneralCheckBox->setChecked(mAppSettings.logMainChat);
   ui->logJoinsPartsCheckBox->setChecked(mAppSettings.logJoinsParts);
@@ -99,9 +102,12 @@ void SettingsDialog::accept() {
   mAppSettings.useEmojiIcons = uiForm->useEmojiIcons->isChecked();
   mAppSettings.notificationStyle = static_cast<AppSettings::NotificationStyle>(
       ui->notifStyleComboBox->currentIndex());
+  mAppSettings.privTabIdleMinutes = ui->privTabIdleSpinBox->value();
+  mAppSettings.maxPrivTabs = ui->maxPrivTabsSpinBox->value();
 
   mAppSettings.blockedContents = saveListWidget(ui->blockedMsgsList);
   mAppSettings.blockedUsers = saveListWidget(ui->blockedUsersList);
+  mAppSettings.autoBlockFlooders = ui->autoBlockFloodersCheckBox->isChecked();
 
   mAppSettings.logMainChat = ui->logGeneralCheckBox->isChecked();
   mAppSettings.logJoinsParts = ui->logJoinsPartsCheckBox->isChecked();
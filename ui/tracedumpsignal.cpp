@@ -0,0 +1,53 @@
+#include "tracedumpsignal.h"
+
+#include <QObject>
+
+#include <czatlib/sessionmanager.h>
+#include <czatlib/sessionmetrics.h>
+#include <czatlib/wiretrace.h>
+
+#ifdef Q_OS_UNIX
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+int signalFds[2];
+
+void onSigusr1(int) {
+  // only async-signal-safe functions are allowed here, so the actual work is
+  // deferred to the event loop.
+  char c = 1;
+  auto rv = ::write(signalFds[0], &c, sizeof(c));
+  Q_UNUSED(rv);
+}
+} // namespace
+
+void installTraceDumpSignalHandler(QObject *parent) {
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFds)) {
+    qInfo() << "Could not create a socket pair for handling SIGUSR1";
+    return;
+  }
+  auto notifier =
+      new QSocketNotifier(signalFds[1], QSocketNotifier::Read, parent);
+  QObject::connect(notifier, &QSocketNotifier::activated, parent, [=]() {
+    char c;
+    auto rv = ::read(signalFds[1], &c, sizeof(c));
+    Q_UNUSED(rv);
+    Czateria::WireTrace::dumpAll();
+    Czateria::SessionMetrics::dumpAll();
+    Czateria::SessionManager::dumpAll();
+  });
+
+  struct sigaction sa = {};
+  sa.sa_handler = onSigusr1;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1, &sa, nullptr);
+}
+#else
+void installTraceDumpSignalHandler(QObject *) {}
+#endif
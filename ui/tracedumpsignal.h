@@ -0,0 +1,11 @@
+#ifndef TRACEDUMPSIGNAL_H
+#define TRACEDUMPSIGNAL_H
+
+class QObject;
+
+// on unix-like systems, makes SIGUSR1 dump the wire traces and the metrics of
+// all the open sessions into the dump directory, and log their overall
+// statistics. a no-op elsewhere.
+void installTraceDumpSignalHandler(QObject *parent);
+
+#endif // TRACEDUMPSIGNAL_H
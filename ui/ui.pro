@@ -31,6 +31,7 @@ SOURCES += \
     notificationsupport_msgbox.cpp \
     settingsbasedblocker.cpp \
     settingsdialog.cpp \
+    tracedumpsignal.cpp \
     userlistview.cpp
 
 HEADERS += \
@@ -46,6 +47,7 @@ HEADERS += \
     notificationsupport_native.h \
     settingsbasedblocker.h \
     settingsdialog.h \
+    tracedumpsignal.h \
     userlistview.h \
     util.h
 